@@ -22,8 +22,10 @@ public:
 			_previousStringValue = *str;
 
 		if (ImGui::IsItemDeactivatedAfterEdit()) {
-			if (str->compare(_previousStringValue) != 0)
-				NodesGraph::GetCurrent()->Execute(new EditValueCommand<std::string>(str, _previousStringValue));
+			if (str->compare(_previousStringValue) != 0) {
+				auto graph = NodesGraph::GetCurrent();
+				graph->Execute(new EditValueCommand<std::string>(str, _previousStringValue, graph, graph->GetCurrentNode()));
+			}
 		}
 	}
 
@@ -38,13 +40,17 @@ public:
 		}
 
 		if (ImGui::IsItemDeactivatedAfterEdit()) {
-			if (_previousFloatValue != *v)
-				NodesGraph::GetCurrent()->Execute(new EditValueCommand<float>(v, _previousFloatValue));
+			if (_previousFloatValue != *v) {
+				auto graph = NodesGraph::GetCurrent();
+				graph->Execute(new EditValueCommand<float>(v, _previousFloatValue, graph, graph->GetCurrentNode()));
+			}
 		}
 		else if (ImGui::IsItemEdited() && ImGui::IsItemActivated() && previousValue != *v)
 		{
-			if (previousValue != *v)
-				NodesGraph::GetCurrent()->Execute(new EditValueCommand<float>(v, previousValue));
+			if (previousValue != *v) {
+				auto graph = NodesGraph::GetCurrent();
+				graph->Execute(new EditValueCommand<float>(v, previousValue, graph, graph->GetCurrentNode()));
+			}
 		}
 	}
 };
\ No newline at end of file
@@ -18,6 +18,16 @@
 // graph
 #include "nodes_graph.h"
 #include "nodes_graph_settings.h"
+#include "autosave.h"
+#include "graph_builder.h"
+#include "template_node.h"
+#include "subgraph_node.h"
+#include "graph_diff.h"
+
+// commands
+#include "commands/create_node_command.h"
+#include "commands/create_connection_command.h"
+#include "commands/create_nodes_command.h"
 
 // nodes
 #include "nodes/entry_node.h"
@@ -44,10 +54,30 @@ static bool _newFileInputFocused = false;
 static std::string _newFileName;
 
 static bool _showStatsWindow = false;
+static double _graphDrawTime = 0;
+
+static int _benchmarkNodeCount = 10000;
+static double _benchmarkCommandsTime = 0;
+static double _benchmarkBuilderTime = 0;
+static int _benchmarkInstanceCount = 1000;
+static double _benchmarkInstanceTime = 0;
+static size_t _benchmarkInstanceMemory = 0;
+static double _benchmarkExpandTime = 0;
+static size_t _benchmarkExpandMemory = 0;
 static bool _showHistoryWindow = false;
+static bool _showSearchWindow = false;
+
+static bool _focusSearchInput = false;
+static std::string _searchQuery;
+static std::vector<SearchHit> _searchHits;
+static NodesGraph* _searchedGraph = nullptr;
+static uint64_t _searchedVersion = 0;
+static double _searchTime = 0;
 
 static std::string _directory;
 static bool _filesLoaded = false;
+static uint64_t _filesVersion = 0;
+static uint64_t _savedTemplatesVersion = 0;
 
 static std::vector<std::string> _files;
 static std::string _currentFile; // focused graph
@@ -56,11 +86,20 @@ static std::string _focusedFile; // right clicked
 static std::string _renamedFile;
 
 static std::map<std::string, NodesGraph*> _openedGraphs;
+static struct {
+	std::string graph;
+	std::string name;
+	std::string value;
+	NodeKey::Role role;
+} _navigation;
 static NodesGraph* _focusedGraph = nullptr;
 static std::string _closingGraph;
 
 static bool _showSavePopup = false;
 
+static Autosave _autosave;
+static double _lastInputTime = 0;
+
 static bool _done = false;
 static bool _closing = false;
 
@@ -80,12 +119,26 @@ static void UserData_ReadLine(ImGuiContext* ctx, ImGuiSettingsHandler* handler,
 		_showStatsWindow = (strcmp(value, "true") == 0);
 	else if (sscanf(line, "HistoryWindow=%10s", value) == 1)
 		_showHistoryWindow = (strcmp(value, "true") == 0);
+	else if (sscanf(line, "SearchWindow=%10s", value) == 1)
+		_showSearchWindow = (strcmp(value, "true") == 0);
 	else if (sscanf(line, "ValidateNodes=%10s", value) == 1)
 		NodesGraphSettings::ValidateNodesRef() = (strcmp(value, "true") == 0);
+	else if (sscanf(line, "HighlightUnreachable=%10s", value) == 1)
+		NodesGraphSettings::HighlightUnreachableNodesRef() = (strcmp(value, "true") == 0);
 	else if (sscanf(line, "EnableSnapping=%10s", value) == 1)
 		NodesGraphSettings::NodeSnappingEnabledRef() = (strcmp(value, "true") == 0);
 	else if (sscanf(line, "NodeSnapping=%d", &valueInt) == 1)
 		NodesGraphSettings::NodeSnappingValueRef() = valueInt;
+	else if (sscanf(line, "HistoryMaxCommands=%d", &valueInt) == 1)
+		NodesGraphSettings::HistoryMaxCommandsRef() = valueInt;
+	else if (sscanf(line, "HistoryMaxMegabytes=%d", &valueInt) == 1)
+		NodesGraphSettings::HistoryMaxMegabytesRef() = valueInt;
+	else if (sscanf(line, "Autosave=%10s", value) == 1)
+		NodesGraphSettings::AutosaveEnabledRef() = (strcmp(value, "true") == 0);
+	else if (sscanf(line, "AutosaveInterval=%d", &valueInt) == 1)
+		NodesGraphSettings::AutosaveIntervalRef() = valueInt;
+	else if (sscanf(line, "AutosaveBackups=%d", &valueInt) == 1)
+		NodesGraphSettings::AutosaveBackupsRef() = valueInt;
 }
 
 static void UserData_WriteAll(ImGuiContext* ctx, ImGuiSettingsHandler* handler, ImGuiTextBuffer* buffer)
@@ -94,27 +147,75 @@ static void UserData_WriteAll(ImGuiContext* ctx, ImGuiSettingsHandler* handler,
 	buffer->appendf("Path=%s\n", _directory.c_str());
 	buffer->appendf("DebugWindow=%s\n", _showStatsWindow ? "true" : "false");
 	buffer->appendf("HistoryWindow=%s\n", _showHistoryWindow ? "true" : "false");
+	buffer->appendf("SearchWindow=%s\n", _showSearchWindow ? "true" : "false");
 	buffer->appendf("ValidateNodes=%s\n", NodesGraphSettings::ValidateNodes() ? "true" : "false");
+	buffer->appendf("HighlightUnreachable=%s\n", NodesGraphSettings::HighlightUnreachableNodes() ? "true" : "false");
 	buffer->appendf("EnableSnapping=%s\n", NodesGraphSettings::NodeSnappingEnabled() ? "true" : "false");
 	buffer->appendf("NodeSnapping=%d\n", NodesGraphSettings::NodeSnappingValue());
+	buffer->appendf("HistoryMaxCommands=%d\n", NodesGraphSettings::HistoryMaxCommands());
+	buffer->appendf("HistoryMaxMegabytes=%d\n", NodesGraphSettings::HistoryMaxMegabytes());
+	buffer->appendf("Autosave=%s\n", NodesGraphSettings::AutosaveEnabled() ? "true" : "false");
+	buffer->appendf("AutosaveInterval=%d\n", NodesGraphSettings::AutosaveInterval());
+	buffer->appendf("AutosaveBackups=%d\n", NodesGraphSettings::AutosaveBackups());
+}
+
+static std::string GetTemplatesPath()
+{
+	return _directory + "/templates.json";
 }
 
-static SDL_EnumerationResult EnumerateDirectoryCallback(void* userdata, const char* dirname, const char* fname)
+static void LoadTemplates()
 {
-	auto fullFileName = std::string(fname);
-	auto pos = fullFileName.find(".sgraph");
-	if (pos != std::string::npos) {
-		auto fileName = fullFileName.substr(0, pos);
-		_files.emplace_back(fileName);
+	auto& templates = NodesGraph::GetTemplates();
+
+	size_t dataSize = 0;
+	auto data = (char*)SDL_LoadFile(GetTemplatesPath().c_str(), &dataSize);
+	if (data == nullptr || !templates.Deserialize(std::string(data, dataSize)))
+		templates.Clear();
+
+	SDL_free(data);
+	_savedTemplatesVersion = templates.GetVersion();
+}
+
+static void SaveTemplatesIfChanged()
+{
+	auto& templates = NodesGraph::GetTemplates();
+	if (_directory.empty() || templates.GetVersion() == _savedTemplatesVersion)
+		return;
+
+	auto data = templates.Serialize();
+	auto stream = SDL_IOFromFile(GetTemplatesPath().c_str(), "w");
+	if (stream != nullptr) {
+		SDL_WriteIO(stream, data.c_str(), data.size());
+		SDL_CloseIO(stream);
 	}
 
-	return SDL_ENUM_CONTINUE;
+	_savedTemplatesVersion = templates.GetVersion();
 }
 
-static void LoadFilesAtDirectory()
+static void UpdateFiles()
 {
+	// Changes made to the directory by other programs too.
+	auto& project = NodesGraph::GetProject();
+	project.Poll();
+
+	if (_filesVersion == project.GetVersion())
+		return;
+
 	_files.clear();
-	SDL_EnumerateDirectory(_directory.c_str(), EnumerateDirectoryCallback, nullptr);
+	for (const auto& info : project.GetFiles())
+		_files.push_back(info.name);
+
+	_filesVersion = project.GetVersion();
+}
+
+static void LoadFilesAtDirectory()
+{
+	// Only graphs changed since the index file was written are read, and of
+	// those only the header line.
+	NodesGraph::GetProject().Open(_directory);
+
+	LoadTemplates();
 	_filesLoaded = true;
 }
 
@@ -133,6 +234,10 @@ static void CloseGraph(std::string filename)
 	auto graph = _openedGraphs.at(filename);
 	_openedGraphs.erase(filename);
 
+	// Either saved or explicitly discarded at this point.
+	graph->CloseJournal(true);
+	_autosave.Forget(graph);
+
 	if (_focusedGraph == graph) {
 		if (_openedGraphs.size() > 0) {
 			_focusedGraph = _openedGraphs.begin()->second;
@@ -147,6 +252,54 @@ static void CloseGraph(std::string filename)
 	delete graph;
 }
 
+static void SaveGraph(const std::string& graphName, NodesGraph* graph)
+{
+	// The file already is what would be written, e.g. after undoing back to it.
+	auto& project = NodesGraph::GetProject();
+	auto info = project.Find(graphName);
+	if (info != nullptr && info->hasHeader && info->hash == FormatHash(graph->GetContentHash()) && graph->IsSerializedUnchanged()) {
+		graph->MarkSaved();
+		return;
+	}
+
+	char filename[100];
+	SDL_snprintf(filename, 100, "%s/%s.%s", _directory.c_str(), graphName.c_str(), "sgraph");
+
+	auto data = graph->Serialize();
+	auto stream = SDL_IOFromFile(filename, "w");
+	SDL_WriteIO(stream, data.c_str(), data.size());
+	SDL_CloseIO(stream);
+
+	// Keys it exports may have changed for the other graphs.
+	project.Refresh(graphName);
+}
+
+// Opens the graph and focuses the first node declaring the key in the given
+// role. Deferred to the end of the frame, the request comes from inside Draw.
+static void NavigateToKey(const std::string& graphName, const std::string& name, const std::string& value, NodeKey::Role role)
+{
+	_navigation = { graphName, name, value, role };
+}
+
+static void OpenGraph(std::string graphName);
+
+static void UpdateNavigation()
+{
+	if (_navigation.graph.empty()) return;
+
+	OpenGraph(_navigation.graph);
+
+	auto& keyIndex = _focusedGraph->GetKeyIndex();
+	auto& nodes = _navigation.role == NodeKey::Definition ?
+		keyIndex.GetDefinitions(_navigation.name, _navigation.value) :
+		keyIndex.GetReferences(_navigation.name, _navigation.value);
+
+	if (!nodes.empty())
+		_focusedGraph->FocusOnNode(nodes.front());
+
+	_navigation = {};
+}
+
 static void OpenGraph(std::string graphName)
 {
 	char filename[100];
@@ -164,10 +317,27 @@ static void OpenGraph(std::string graphName)
 		fileData[dataSize] = '\0';
 		SDL_ReadIO(stream, fileData, dataSize);
 
-		graph->Deserialize(fileData);
+		// A journal left behind means the editor did not close cleanly, replay
+		// the changes it recorded on top of the saved graph.
+		auto journalFilename = std::string(filename) + ".journal";
+		size_t journalSize = 0;
+		auto journalData = (char*)SDL_LoadFile(journalFilename.c_str(), &journalSize);
+
+		if (journalData != nullptr && journalSize > 0)
+			graph->Recover(fileData, std::string(journalData, journalSize));
+		else
+			graph->Deserialize(fileData);
 
+		SDL_free(journalData);
 		free(fileData);
 		SDL_CloseIO(stream);
+
+		// Files without a header get a new id when loaded.
+		auto info = NodesGraph::GetProject().Find(graphName);
+		if (info == nullptr || info->id != graph->GetId())
+			NodesGraph::GetProject().Update(graphName, *graph);
+
+		graph->OpenJournal(journalFilename);
 	}
 
 	_focusedGraph = _openedGraphs[graphName];
@@ -194,15 +364,7 @@ static void DrawMenuBar()
 			ImGui::Separator();
 			if (ImGui::MenuItem("Save", "Ctrl+S", nullptr, _focusedGraph && _focusedGraph->HasUnsavedChanges()))
 			{
-				// TODO: Fix all of these
-				auto data = _focusedGraph->Serialize();
-
-				char filename[100];
-				SDL_snprintf(filename, 100, "%s/%s.%s", _directory.c_str(), _currentFile.c_str(), "sgraph");
-
-				auto stream = SDL_IOFromFile(filename, "w");
-				SDL_WriteIO(stream, data.c_str(), data.size());
-				SDL_CloseIO(stream);
+				SaveGraph(_currentFile, _focusedGraph);
 			}
 
 			/*if (ImGui::MenuItem("Save All", "Ctrl+Shift+S", nullptr, false)) {
@@ -214,16 +376,18 @@ static void DrawMenuBar()
 
 		if (ImGui::BeginMenu("Edit"))
 		{
-			if (ImGui::MenuItem("Undo", "Ctrl+Z", nullptr, _focusedGraph && !_focusedGraph->GetUndoStack().empty()))
-				_focusedGraph->Undo();
-			if (ImGui::MenuItem("Redo", "Ctrl+Y", nullptr, _focusedGraph && !_focusedGraph->GetRedoStack().empty()))
-				_focusedGraph->Redo();
+			auto graph = _focusedGraph ? _focusedGraph->GetActiveGraph() : nullptr;
+			if (ImGui::MenuItem("Undo", "Ctrl+Z", nullptr, graph && !graph->GetUndoStack().empty()))
+				graph->Undo();
+			if (ImGui::MenuItem("Redo", "Ctrl+Y", nullptr, graph && !graph->GetRedoStack().empty()))
+				graph->Redo();
 			ImGui::EndMenu();
 		}
 
 		if (ImGui::BeginMenu("View"))
 		{
 			ImGui::MenuItem("History", "", &_showHistoryWindow);
+			ImGui::MenuItem("Search", "Ctrl+F", &_showSearchWindow);
 			ImGui::MenuItem("Stats", "", &_showStatsWindow);
 			ImGui::EndMenu();
 		}
@@ -231,6 +395,7 @@ static void DrawMenuBar()
 		if (ImGui::BeginMenu("Settings"))
 		{
 			if (ImGui::MenuItem("Validate Nodes", NULL, &NodesGraphSettings::ValidateNodesRef())) {}
+			ImGui::MenuItem("Highlight Unreachable Nodes", NULL, &NodesGraphSettings::HighlightUnreachableNodesRef());
 			if (ImGui::BeginMenu("Snapping"))
 			{
 				ImGui::MenuItem("Enabled", "", &NodesGraphSettings::NodeSnappingEnabledRef());
@@ -239,6 +404,30 @@ static void DrawMenuBar()
 				ImGui::EndMenu();
 			}
 
+			if (ImGui::BeginMenu("History"))
+			{
+				ImGui::SetNextItemWidth(90_dpi);
+				if (ImGui::InputInt("Max Commands", &NodesGraphSettings::HistoryMaxCommandsRef(), 50, 500))
+					NodesGraphSettings::HistoryMaxCommandsRef() = ImMax(NodesGraphSettings::HistoryMaxCommands(), 0);
+				ImGui::SetNextItemWidth(90_dpi);
+				if (ImGui::InputInt("Max Memory (MB)", &NodesGraphSettings::HistoryMaxMegabytesRef(), 16, 128))
+					NodesGraphSettings::HistoryMaxMegabytesRef() = ImMax(NodesGraphSettings::HistoryMaxMegabytes(), 0);
+				ImGui::TextDisabled("0 means unlimited");
+				ImGui::EndMenu();
+			}
+
+			if (ImGui::BeginMenu("Autosave"))
+			{
+				ImGui::MenuItem("Enabled", "", &NodesGraphSettings::AutosaveEnabledRef());
+				ImGui::SetNextItemWidth(90_dpi);
+				if (ImGui::InputInt("Interval (s)", &NodesGraphSettings::AutosaveIntervalRef(), 10, 60))
+					NodesGraphSettings::AutosaveIntervalRef() = ImMax(NodesGraphSettings::AutosaveInterval(), 5);
+				ImGui::SetNextItemWidth(90_dpi);
+				if (ImGui::InputInt("Backups", &NodesGraphSettings::AutosaveBackupsRef(), 1, 1))
+					NodesGraphSettings::AutosaveBackupsRef() = ImClamp(NodesGraphSettings::AutosaveBackups(), 1, 20);
+				ImGui::EndMenu();
+			}
+
 			ImGui::EndMenu();
 		}
 
@@ -271,8 +460,9 @@ static void DrawDirectoryFiles()
 			std::ofstream file(fullPath);
 			if (file) file.close();
 
+			NodesGraph::GetProject().Refresh(_newFileName);
+
 			_creatingNewFile = false;
-			_filesLoaded = false;
 			_newFileName.clear();
 		}
 	}
@@ -299,6 +489,29 @@ static void DrawDirectoryFiles()
 
 			if (ImGui::IsItemHovered())
 				_hoveredFile = _files[i];
+
+			auto info = NodesGraph::GetProject().Find(_files[i]);
+			if (info != nullptr)
+			{
+				// Still for the selectable, before the count is drawn after it.
+				if (ImGui::BeginItemTooltip())
+				{
+					ImGui::Text("%d nodes, %d connections, %d keys", (int)info->nodeCount, (int)info->connectionCount, (int)info->keys.size());
+					ImGui::Text("%d invalid nodes", (int)info->invalidCount);
+					ImGui::TextDisabled("Hash %s", info->hash.empty() ? "-" : info->hash.c_str());
+
+					for (const auto& identical : NodesGraph::GetProject().FindIdentical(info->name))
+						ImGui::TextDisabled("Same as %s", identical.c_str());
+
+					ImGui::EndTooltip();
+				}
+
+				if (info->invalidCount > 0)
+				{
+					ImGui::SameLine();
+					ImGui::TextColored(ImVec4(1, 0, 0, 1), "(%d)", (int)info->invalidCount);
+				}
+			}
 		}
 	}
 
@@ -395,6 +608,142 @@ static void DrawTabs()
 	ImGui::PopStyleVar();
 }
 
+// Builds the same chain of nodes into a scratch graph once command by
+// command and once with GraphBuilder, timing both (in ms).
+static void RunBuildBenchmark(int nodeCount)
+{
+	auto typeId = NodesGraph::FindNodeType("Speech");
+	auto nodeType = NodesGraph::GetNodeType(typeId);
+	if (nodeType == nullptr) return;
+
+	auto frequency = (double)SDL_GetPerformanceFrequency();
+	auto position = [](int i) { return ImVec2((float)(i % 100) * 200, (float)(i / 100) * 120); };
+
+	{
+		NodesGraph graph;
+		auto start = SDL_GetPerformanceCounter();
+
+		Node* previous = nullptr;
+		for (int i = 0; i < nodeCount; i++)
+		{
+			auto node = nodeType->create(position(i));
+			graph.Execute(new CreateNodeCommand(node, &graph));
+
+			if (previous != nullptr)
+				graph.Execute(new CreateConnectionCommand(new NodeConnection(previous->GetSlots()[2], node->GetSlots()[0]), &graph));
+
+			previous = node;
+		}
+
+		_benchmarkCommandsTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+	}
+
+	{
+		NodesGraph graph;
+		auto start = SDL_GetPerformanceCounter();
+
+		GraphBuilder builder(&graph);
+		builder.Reserve(nodeCount, nodeCount);
+
+		for (int i = 0; i < nodeCount; i++)
+		{
+			auto index = builder.AddNode(typeId, position(i));
+			if (index > 0)
+				builder.AddConnection(index - 1, 2, index, 0);
+		}
+
+		graph.Execute(builder.Commit());
+
+		_benchmarkBuilderTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+	}
+}
+
+// Instances a 20 node template into a scratch graph, once by reference and
+// once expanded, timing both (in ms) and measuring the memory of the nodes.
+static void RunTemplateBenchmark(int instanceCount)
+{
+	auto typeId = NodesGraph::FindNodeType("Speech");
+	auto nodeType = NodesGraph::GetNodeType(typeId);
+	auto instanceType = NodesGraph::GetNodeType(NodesGraph::FindNodeType(TemplateNode::TypeName));
+	if (nodeType == nullptr || instanceType == nullptr) return;
+
+	auto& templates = NodesGraph::GetTemplates();
+	auto templatesVersion = templates.GetVersion();
+
+	std::string templateId;
+	{
+		NodesGraph graph;
+		GraphBuilder builder(&graph);
+
+		for (int i = 0; i < 20; i++)
+		{
+			auto index = builder.AddNode(typeId, ImVec2((float)i * 200, 0));
+			if (index > 0)
+				builder.AddConnection(index - 1, 2, index, 0);
+		}
+
+		graph.Execute(builder.Commit());
+
+		std::vector<Node*> nodes;
+		for (const auto& [_, node] : graph.GetNodes())
+			nodes.push_back(node);
+
+		templateId = graph.CreateTemplate("Benchmark", nodes);
+	}
+
+	auto frequency = (double)SDL_GetPerformanceFrequency();
+	auto position = [](int i) { return ImVec2((float)(i % 10) * 4000, (float)(i / 10) * 200); };
+	auto getMemoryUsage = [](NodesGraph& graph) {
+		size_t usage = 0;
+		for (const auto& [_, node] : graph.GetNodes())
+			usage += node->GetMemoryUsage();
+		return usage;
+		};
+
+	{
+		NodesGraph graph;
+		auto start = SDL_GetPerformanceCounter();
+
+		GraphBuilder builder(&graph);
+		builder.Reserve(instanceCount, 0);
+
+		for (int i = 0; i < instanceCount; i++)
+		{
+			auto instance = static_cast<TemplateNode*>(instanceType->create(position(i)));
+			instance->SetTemplateId(templateId);
+			builder.AddNode(instance);
+		}
+
+		graph.Execute(builder.Commit());
+
+		_benchmarkInstanceTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+		_benchmarkInstanceMemory = getMemoryUsage(graph);
+	}
+
+	{
+		NodesGraph graph;
+		auto start = SDL_GetPerformanceCounter();
+
+		std::vector<Node*> nodes;
+		std::vector<NodeConnection*> connections;
+		nodes.reserve(instanceCount * 20);
+		connections.reserve(instanceCount * 19);
+
+		for (int i = 0; i < instanceCount; i++)
+			templates.Instantiate(templateId, position(i), nlohmann::json::object(), nodes, connections);
+
+		graph.Execute(new CreateNodesCommand(std::move(nodes), std::move(connections), &graph));
+
+		_benchmarkExpandTime = (SDL_GetPerformanceCounter() - start) * 1000.0 / frequency;
+		_benchmarkExpandMemory = getMemoryUsage(graph);
+	}
+
+	// The benchmark template isn't worth saving the library for.
+	templates.Remove(templateId);
+	if (_savedTemplatesVersion == templatesVersion)
+		_savedTemplatesVersion = templates.GetVersion();
+}
+
 static void DrawStatsWindow()
 {
 	if (!_showStatsWindow) return;
@@ -413,11 +762,47 @@ static void DrawStatsWindow()
 		ImGui::Text("FPS: %.1f", ImGui::GetIO().Framerate);
 
 		if (_focusedGraph) {
-			ImGui::Text("Scale: %.2f", _focusedGraph->GetScale());
-			ImGui::Text("Scroll: (%.1f, %.1f)", _focusedGraph->GetOffset().x, _focusedGraph->GetOffset().y);
-			ImGui::Text("Nodes: %d", (int)_focusedGraph->GetNodes().size());
-			ImGui::Text("Connections: %d", (int)_focusedGraph->GetConnections().size());
+			auto graph = _focusedGraph->GetActiveGraph();
+			ImGui::Text("Draw: %.2f ms", _graphDrawTime);
+			ImGui::Text("Scale: %.2f", graph->GetScale());
+			ImGui::Text("Scroll: (%.1f, %.1f)", graph->GetOffset().x, graph->GetOffset().y);
+			ImGui::Text("Nodes: %d", (int)graph->GetNodes().size());
+			ImGui::Text("Connections: %d", (int)graph->GetConnections().size());
+			ImGui::Text("Queued Commands: %d", (int)graph->GetQueuedCommandCount());
+			ImGui::Text("Duplicate Keys: %d", (int)graph->GetKeyIndex().GetDuplicateCount());
+			ImGui::Text("Orphaned Keys: %d", (int)graph->GetKeyIndex().GetOrphanCount());
 		}
+
+		auto autosave = _autosave.GetMetrics();
+		ImGui::SeparatorText("Autosave");
+		ImGui::Text("Snapshot: %.2f ms (max %.2f)", autosave.lastSnapshotMs, autosave.maxSnapshotMs);
+		ImGui::Text("Write: %.2f ms (max %.2f)", autosave.lastWriteMs, autosave.maxWriteMs);
+		ImGui::Text("Saves: %d, Throttled: %d, Failed: %d", (int)autosave.writes, (int)autosave.throttled, (int)autosave.failures);
+
+		ImGui::SeparatorText("Build Benchmark");
+		ImGui::SetNextItemWidth(96_dpi);
+		if (ImGui::InputInt("Nodes", &_benchmarkNodeCount, 1000, 10000))
+			_benchmarkNodeCount = _benchmarkNodeCount < 1 ? 1 : _benchmarkNodeCount > 1000000 ? 1000000 : _benchmarkNodeCount;
+
+		ImGui::SameLine();
+		if (ImGui::Button("Run"))
+			RunBuildBenchmark(_benchmarkNodeCount);
+
+		ImGui::Text("Commands: %.1f ms", _benchmarkCommandsTime);
+		ImGui::Text("Builder: %.1f ms", _benchmarkBuilderTime);
+
+		ImGui::SeparatorText("Template Benchmark");
+		ImGui::SetNextItemWidth(96_dpi);
+		if (ImGui::InputInt("Instances", &_benchmarkInstanceCount, 100, 1000))
+			_benchmarkInstanceCount = _benchmarkInstanceCount < 1 ? 1 : _benchmarkInstanceCount > 100000 ? 100000 : _benchmarkInstanceCount;
+
+		ImGui::SameLine();
+		if (ImGui::Button("Run##Templates"))
+			RunTemplateBenchmark(_benchmarkInstanceCount);
+
+		ImGui::Text("Instanced: %.1f ms, %.1f KB", _benchmarkInstanceTime, _benchmarkInstanceMemory / 1024.0f);
+		ImGui::Text("Expanded: %.1f ms, %.1f KB", _benchmarkExpandTime, _benchmarkExpandMemory / 1024.0f);
+		ImGui::Text("Library: %.1f KB", NodesGraph::GetTemplates().GetMemoryUsage() / 1024.0f);
 	}
 
 	ImGui::End();
@@ -441,11 +826,16 @@ static void DrawHistoryWindow()
 	if (ImGui::Begin("History", &_showHistoryWindow, windowFlags))
 	{
 		if (_focusedGraph != nullptr) {
+			// Inside a subgraph, the history is the subgraph's.
+			auto graph = _focusedGraph->GetActiveGraph();
 			_Command* commandUndoClicked = nullptr;
 			_Command* commandRedoClicked = nullptr;
 
-			auto& redoStack = _focusedGraph->GetRedoStack();
-			auto& undoStack = _focusedGraph->GetUndoStack();
+			auto& redoStack = graph->GetRedoStack();
+			auto& undoStack = graph->GetUndoStack();
+
+			ImGui::TextDisabled("%d commands, %.1f KB", (int)(undoStack.size() + redoStack.size()), graph->GetHistoryMemoryUsage() / 1024.0f);
+			ImGui::Separator();
 
 			int cmdId = 0;
 			for (const auto& it : undoStack)
@@ -466,16 +856,16 @@ static void DrawHistoryWindow()
 
 			if (commandUndoClicked) {
 				while (undoStack.back() != commandUndoClicked) {
-					_focusedGraph->Undo();
+					graph->Undo();
 				}
 			}
 
 			if (commandRedoClicked) {
 				while (redoStack.back() != commandRedoClicked) {
-					_focusedGraph->Redo();
+					graph->Redo();
 				}
 
-				_focusedGraph->Redo();
+				graph->Redo();
 			}
 		}
 	}
@@ -483,6 +873,68 @@ static void DrawHistoryWindow()
 	ImGui::End();
 }
 
+static void DrawSearchWindow()
+{
+	if (!_showSearchWindow) return;
+
+	ImGuiWindowFlags windowFlags =
+		ImGuiWindowFlags_NoFocusOnAppearing |
+		ImGuiWindowFlags_NoNav;
+
+	ImGui::SetNextWindowPos(ImVec2(212_dpi, 240_dpi), ImGuiCond_Appearing, ImVec2(0, 0));
+	ImGui::SetNextWindowSize(ImVec2(320_dpi, 320_dpi), ImGuiCond_FirstUseEver);
+	ImGui::SetNextWindowBgAlpha(0.35f);
+
+	if (ImGui::Begin("Search", &_showSearchWindow, windowFlags))
+	{
+		if (_focusSearchInput) {
+			ImGui::SetKeyboardFocusHere();
+			_focusSearchInput = false;
+		}
+
+		ImGui::SetNextItemWidth(-FLT_MIN);
+		auto queryChanged = ImGui::InputTextWithHint("##query", "Search nodes", &_searchQuery);
+
+		if (_focusedGraph) {
+			auto graph = _focusedGraph->GetActiveGraph();
+			auto& searchIndex = graph->GetSearchIndex();
+
+			// Hits point at nodes, so they are refreshed whenever the indexed content changes.
+			if (queryChanged || _searchedGraph != graph || _searchedVersion != searchIndex.GetVersion()) {
+				auto start = SDL_GetPerformanceCounter();
+				searchIndex.Search(_searchQuery, _searchHits);
+				_searchTime = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+
+				_searchedGraph = graph;
+				_searchedVersion = searchIndex.GetVersion();
+			}
+
+			if (searchIndex.IsBuilding())
+				ImGui::TextDisabled("Indexing...");
+			else if (!_searchQuery.empty())
+				ImGui::TextDisabled("%d results in %.2f ms", (int)_searchHits.size(), _searchTime);
+
+			int hitId = 0;
+			for (const auto& hit : _searchHits)
+			{
+				auto start = hit.position > 24 ? hit.position - 24 : 0;
+				auto snippet = (start > 0 ? "..." : "") + hit.field.substr(start, 64);
+
+				ImGui::PushID(hitId++);
+				if (ImGui::Selectable(snippet.c_str(), false))
+					graph->FocusOnNode(hit.node);
+				ImGui::PopID();
+			}
+		}
+		else {
+			_searchHits.clear();
+			_searchedGraph = nullptr;
+		}
+	}
+
+	ImGui::End();
+}
+
 static void DrawGraphWindow()
 {
 	auto childFlags = 0;
@@ -509,7 +961,9 @@ static void DrawGraphWindow()
 	}
 	else
 	{
+		auto start = SDL_GetPerformanceCounter();
 		_focusedGraph->Draw();
+		_graphDrawTime = (double)(SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
 	}
 
 	ImGui::PopItemWidth();
@@ -542,6 +996,7 @@ static void CheckIfAppIsClosing()
 				}
 			}
 
+			_autosave.Forget(graph);
 			delete graph;
 		}
 
@@ -569,16 +1024,7 @@ static void DrawPopups()
 		ImGui::SetItemDefaultFocus();
 		if (ImGui::Button("Save")) {
 
-			auto graph = _openedGraphs[_closingGraph];
-
-			char filename[100];
-			SDL_snprintf(filename, 100, "%s/%s.%s", _directory.c_str(), _closingGraph.c_str(), "sgraph");
-
-			auto data = graph->Serialize();
-			auto stream = SDL_IOFromFile(filename, "w");
-			SDL_WriteIO(stream, data.c_str(), data.size());
-			SDL_CloseIO(stream);
-
+			SaveGraph(_closingGraph, _openedGraphs[_closingGraph]);
 			CloseGraph(_closingGraph);
 			ImGui::CloseCurrentPopup();
 		}
@@ -605,7 +1051,7 @@ static void DrawPopups()
 		{
 			std::string fullPath = _directory + "/" + _focusedFile + ".sgraph";
 			std::remove(fullPath.c_str());
-			_filesLoaded = false;
+			NodesGraph::GetProject().Remove(_focusedFile);
 		}
 
 		ImGui::BeginDisabled(true);
@@ -619,11 +1065,28 @@ static void DrawPopups()
 	}
 }
 
+static void UpdateAutosave()
+{
+	auto& io = ImGui::GetIO();
+	auto time = ImGui::GetTime();
+
+	if (ImGui::IsAnyItemActive() || ImGui::IsAnyMouseDown() || io.MouseDelta.x != 0 || io.MouseDelta.y != 0 || io.MouseWheel != 0 || !io.InputQueueCharacters.empty())
+		_lastInputTime = time;
+
+	for (const auto& [name, graph] : _openedGraphs)
+	{
+		char filename[100];
+		SDL_snprintf(filename, 100, "%s/%s.%s", _directory.c_str(), name.c_str(), "sgraph");
+		_autosave.Update(graph, filename, time - _lastInputTime);
+	}
+}
+
 static void Draw()
 {
 	_showSavePopup = false;
 	if (!_filesLoaded)
 		LoadFilesAtDirectory();
+	UpdateFiles();
 
 	ImGuiWindowFlags windowFlags = 0;
 	windowFlags |= ImGuiWindowFlags_MenuBar;
@@ -662,9 +1125,12 @@ static void Draw()
 	CheckIfAppIsClosing();
 
 	DrawPopups();
+	SaveTemplatesIfChanged();
+	UpdateNavigation();
 
 	DrawStatsWindow();
 	DrawHistoryWindow();
+	DrawSearchWindow();
 }
 
 static void RegisterNodes()
@@ -676,16 +1142,54 @@ static void RegisterNodes()
 	NodesGraph::RegisterNode<ActionNode>("Action");
 	NodesGraph::RegisterNode<ConnectorInNode>("Connector In");
 	NodesGraph::RegisterNode<ConnectorOutNode>("Connector Out");
+	NodesGraph::RegisterNode<TemplateNode>(TemplateNode::TypeName);
+	NodesGraph::RegisterNode<SubgraphNode>(SubgraphNode::TypeName);
 
 	NodesGraph::RegisterNodeContextMenu<ConnectorInNode>([](ConnectorInNode* node) {
-		if (ImGui::MenuItem("Output")) {
-			auto& nodes = NodesGraph::GetCurrent()->GetNodes();
-			for (const auto& [_, n] : nodes) {
-				auto connectorOutNode = dynamic_cast<ConnectorOutNode*>(n);
-				if (connectorOutNode && connectorOutNode->GetValue() == node->GetValue()) {
-					NodesGraph::GetCurrent()->FocusOnNode(connectorOutNode);
-				}
+		auto graph = NodesGraph::GetCurrent();
+		auto output = graph->GetKeyIndex().FindDefinition("connector", node->GetValue());
+
+		if (ImGui::MenuItem("Output", nullptr, false, output != nullptr))
+			graph->FocusOnNode(output);
+
+		// Outputs in the other graphs of the folder, opened when navigated to.
+		if (output == nullptr)
+		{
+			for (const auto& graphName : NodesGraph::GetProject().GetDefinitions("connector", node->GetValue()))
+			{
+				if (graphName != _currentFile && ImGui::MenuItem(("Output in " + graphName).c_str()))
+					NavigateToKey(graphName, "connector", node->GetValue(), NodeKey::Definition);
+			}
+		}
+		});
+
+	NodesGraph::RegisterNodeContextMenu<ConnectorOutNode>([](ConnectorOutNode* node) {
+		auto graph = NodesGraph::GetCurrent();
+		auto& inputs = graph->GetKeyIndex().GetReferences("connector", node->GetValue());
+
+		if (ImGui::BeginMenu("Inputs", !inputs.empty()))
+		{
+			int inputIndex = 0;
+			for (const auto& input : inputs)
+			{
+				char label[64];
+				SDL_snprintf(label, 64, "Input %d (%.0f, %.0f)", ++inputIndex, input->GetPosition().x, input->GetPosition().y);
+
+				if (ImGui::MenuItem(label))
+					graph->FocusOnNode(input);
+			}
+			ImGui::EndMenu();
+		}
+
+		auto& graphNames = NodesGraph::GetProject().GetReferences("connector", node->GetValue());
+		if (ImGui::BeginMenu("Inputs in Other Graphs", !graphNames.empty()))
+		{
+			for (const auto& graphName : graphNames)
+			{
+				if (graphName != _currentFile && ImGui::MenuItem(graphName.c_str()))
+					NavigateToKey(graphName, "connector", node->GetValue(), NodeKey::Reference);
 			}
+			ImGui::EndMenu();
 		}
 		});
 }
@@ -696,21 +1200,105 @@ static void HandleInput()
 
 	if ((ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyPressed(ImGuiKey_Y)) ||
 		(ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyDown(ImGuiKey_LeftShift) && ImGui::IsKeyPressed(ImGuiKey_Z)))
-		_focusedGraph->Redo();
+		_focusedGraph->GetActiveGraph()->Redo();
 
 	else if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyPressed(ImGuiKey_Z))
-		_focusedGraph->Undo();
+		_focusedGraph->GetActiveGraph()->Undo();
 
-	if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyPressed(ImGuiKey_S)) {
-		auto data = _focusedGraph->Serialize();
+	if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyPressed(ImGuiKey_F)) {
+		_showSearchWindow = true;
+		_focusSearchInput = true;
+	}
 
-		char filename[100];
-		SDL_snprintf(filename, 100, "%s/%s.%s", _directory.c_str(), _currentFile.c_str(), "sgraph");
+	if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && ImGui::IsKeyPressed(ImGuiKey_S))
+		SaveGraph(_currentFile, _focusedGraph);
+}
 
-		auto stream = SDL_IOFromFile(filename, "w");
-		SDL_WriteIO(stream, data.c_str(), data.size());
-		SDL_CloseIO(stream);
+static bool LoadDocument(const char* path, GraphDocument& document)
+{
+	size_t dataSize = 0;
+	auto data = (char*)SDL_LoadFile(path, &dataSize);
+	if (data == nullptr) {
+		fprintf(stderr, "Can't read %s: %s\n", path, SDL_GetError());
+		return false;
 	}
+
+	auto isParsed = document.Parse(std::string(data, dataSize));
+	SDL_free(data);
+
+	if (!isParsed)
+		fprintf(stderr, "%s is not a graph.\n", path);
+
+	return isParsed;
+}
+
+static std::string SerializeMerged(const GraphDocument& document)
+{
+	auto data = document.Serialize();
+
+	// Saved by a graph for the full header, unless it can't load every node.
+	ImGui::CreateContext();
+	RegisterNodes();
+
+	auto graph = new NodesGraph();
+	graph->Deserialize(data);
+	if (graph->GetNodes().size() == document.nodes.size() && graph->GetConnections().size() == document.connections.size())
+		data = graph->Serialize();
+
+	delete graph;
+	ImGui::DestroyContext();
+
+	return data;
+}
+
+// nodes-graph diff <base> <other>
+// nodes-graph merge <base> <ours> <theirs> [<output>]
+//
+// Exit code 0 without changes/conflicts, 1 with, 2 on errors. Merging writes
+// to <ours> without an output, as a git merge driver: merge %O %A %B.
+static int RunCommandLine(int argc, char** argv)
+{
+	std::string command = argv[1];
+
+	if (command == "diff" && argc == 4)
+	{
+		GraphDocument base, other;
+		if (!LoadDocument(argv[2], base) || !LoadDocument(argv[3], other))
+			return 2;
+
+		std::vector<GraphChange> changes;
+		GraphDiff::Compare(base, other, changes);
+
+		for (const auto& change : changes)
+			printf("%s\n", GraphDiff::Describe(change).c_str());
+
+		return changes.empty() ? 0 : 1;
+	}
+
+	if (command == "merge" && (argc == 5 || argc == 6))
+	{
+		GraphDocument base, ours, theirs;
+		if (!LoadDocument(argv[2], base) || !LoadDocument(argv[3], ours) || !LoadDocument(argv[4], theirs))
+			return 2;
+
+		std::vector<GraphConflict> conflicts;
+		GraphDiff::Merge(base, ours, theirs, conflicts);
+
+		auto data = SerializeMerged(ours);
+		auto outputPath = argc == 6 ? argv[5] : argv[3];
+		if (!SDL_SaveFile(outputPath, data.c_str(), data.size())) {
+			fprintf(stderr, "Can't write %s: %s\n", outputPath, SDL_GetError());
+			return 2;
+		}
+
+		for (const auto& conflict : conflicts)
+			printf("%s\n", GraphDiff::Describe(conflict).c_str());
+
+		return conflicts.empty() ? 0 : 1;
+	}
+
+	fprintf(stderr, "Usage:\n  %s diff <base> <other>\n  %s merge <base> <ours> <theirs> [<output>]\n", argv[0], argv[0]);
+	return 2;
 }
 
 #ifdef _DEBUG
@@ -718,13 +1306,16 @@ static void HandleInput()
 #include <crtdbg.h>
 #endif
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
 #ifdef _DEBUG
 	_CrtSetDbgFlag(_CRTDBG_ALLOC_MEM_DF | _CRTDBG_LEAK_CHECK_DF);
 	_CrtSetReportMode(_CRT_WARN, _CRTDBG_MODE_DEBUG);
 #endif
 
+	if (argc > 1)
+		return RunCommandLine(argc, argv);
+
 	// Setup SDL
 	if (!SDL_Init(SDL_INIT_VIDEO))
 	{
@@ -781,6 +1372,7 @@ int main(int, char**)
 
 	NodesGraphSettings::SetDpiScale(contentScale);
 	RegisterNodes();
+	_autosave.Start();
 
 	while (!_done)
 	{
@@ -806,6 +1398,7 @@ int main(int, char**)
 
 		HandleInput();
 		Draw();
+		UpdateAutosave();
 
 		ImGui::Render();
 		SDL_SetRenderScale(renderer, io.DisplayFramebufferScale.x, io.DisplayFramebufferScale.y);
@@ -817,6 +1410,8 @@ int main(int, char**)
 		SDL_RenderPresent(renderer);
 	}
 
+	_autosave.Stop();
+
 	ImGui_ImplSDLRenderer3_Shutdown();
 	ImGui_ImplSDL3_Shutdown();
 	ImGui::DestroyContext();
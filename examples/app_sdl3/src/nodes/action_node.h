@@ -44,6 +44,16 @@ private:
 		return true;
 	}
 
+	void _GetSearchFields(std::vector<std::string>& fields) override
+	{
+		fields.push_back(_value);
+	}
+
+	size_t _GetMemoryUsage() const override
+	{
+		return sizeof(ActionNode) + _value.capacity();
+	}
+
 	Node* _Clone() override
 	{
 		auto clone = new ActionNode();
@@ -10,6 +10,7 @@ private:
 	void _Init() override
 	{
 		_colorOutline = ImColor(229, 56, 136);
+		_isExit = true;
 
 		AddSlot(SlotPosition::Left, true, false);
 		AddSlot(SlotPosition::Top, true, false);
@@ -32,6 +33,35 @@ private:
 		j.at("value").get_to(_value);
 	}
 
+	bool _Validate() override
+	{
+		auto graph = NodesGraph::GetCurrent();
+		if (graph->GetKeyIndex().IsOrphaned("connector", _value) &&
+			!NodesGraph::GetProject().IsDefinedElsewhere("connector", _value, graph->GetId()))
+		{
+			SetValidationMessage("No matching Connector Out.");
+			return false;
+		}
+
+		return true;
+	}
+
+	void _GetKeys(std::vector<NodeKey>& keys) override
+	{
+		if (!_value.empty())
+			keys.push_back({ "connector", _value, NodeKey::Reference });
+	}
+
+	void _GetSearchFields(std::vector<std::string>& fields) override
+	{
+		fields.push_back(_value);
+	}
+
+	size_t _GetMemoryUsage() const override
+	{
+		return sizeof(ConnectorInNode) + _value.capacity();
+	}
+
 	Node* _Clone() override
 	{
 		auto clone = new ConnectorInNode();
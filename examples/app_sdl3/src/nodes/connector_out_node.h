@@ -10,6 +10,7 @@ private:
 	void _Init() override
 	{
 		_colorOutline = ImColor(229, 56, 136);
+		_isEntry = true;
 
 		AddSlot(SlotPosition::Left, false, true);
 		AddSlot(SlotPosition::Top, false, true);
@@ -32,6 +33,40 @@ private:
 		j.at("value").get_to(_value);
 	}
 
+	bool _Validate() override
+	{
+		auto graph = NodesGraph::GetCurrent();
+		if (graph->GetKeyIndex().IsDuplicate("connector", _value))
+		{
+			SetValidationMessage("Id is used by another Connector Out.");
+			return false;
+		}
+
+		if (!_value.empty() && NodesGraph::GetProject().IsDefinedElsewhere("connector", _value, graph->GetId()))
+		{
+			SetValidationMessage("Id is used by a Connector Out in another graph.");
+			return false;
+		}
+
+		return true;
+	}
+
+	void _GetKeys(std::vector<NodeKey>& keys) override
+	{
+		if (!_value.empty())
+			keys.push_back({ "connector", _value, NodeKey::Definition });
+	}
+
+	void _GetSearchFields(std::vector<std::string>& fields) override
+	{
+		fields.push_back(_value);
+	}
+
+	size_t _GetMemoryUsage() const override
+	{
+		return sizeof(ConnectorOutNode) + _value.capacity();
+	}
+
 	Node* _Clone() override
 	{
 		auto clone = new ConnectorOutNode();
@@ -6,6 +6,8 @@ class EntryNode : public Node
 private:
 	void _Init() override
 	{
+		_isEntry = true;
+
 		AddSlot(SlotPosition::Left, false, true);
 		AddSlot(SlotPosition::Top, false, true);
 		AddSlot(SlotPosition::Right, false, true);
@@ -24,6 +26,11 @@ private:
 	{
 	}
 
+	size_t _GetMemoryUsage() const override
+	{
+		return sizeof(EntryNode);
+	}
+
 	Node* _Clone() override
 	{
 		return new EntryNode();
@@ -6,6 +6,8 @@ class ExitNode : public Node
 private:
 	void _Init() override
 	{
+		_isExit = true;
+
 		AddSlot(SlotPosition::Left, true, false);
 		AddSlot(SlotPosition::Top, true, false);
 		AddSlot(SlotPosition::Right, true, false);
@@ -24,6 +26,11 @@ private:
 	{
 	}
 
+	size_t _GetMemoryUsage() const override
+	{
+		return sizeof(ExitNode);
+	}
+
 	Node* _Clone() override
 	{
 		return new ExitNode();
@@ -37,6 +37,16 @@ private:
 		return true;
 	}
 
+	void _GetSearchFields(std::vector<std::string>& fields) override
+	{
+		fields.push_back(_text);
+	}
+
+	size_t _GetMemoryUsage() const override
+	{
+		return sizeof(ResponseNode) + _text.capacity();
+	}
+
 	Node* _Clone() override
 	{
 		auto clone = new ResponseNode();
@@ -68,6 +78,11 @@ private:
 	{
 	}
 
+	size_t _GetMemoryUsage() const override
+	{
+		return sizeof(ResponsesNode);
+	}
+
 	Node* _Clone() override
 	{
 		return new ResponsesNode();
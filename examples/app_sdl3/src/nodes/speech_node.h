@@ -53,6 +53,17 @@ private:
 		return true;
 	}
 
+	void _GetSearchFields(std::vector<std::string>& fields) override
+	{
+		fields.push_back(_target);
+		fields.push_back(_text);
+	}
+
+	size_t _GetMemoryUsage() const override
+	{
+		return sizeof(SpeechNode) + _target.capacity() + _text.capacity();
+	}
+
 	Node* _Clone() override
 	{
 		auto node = new SpeechNode();
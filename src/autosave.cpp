@@ -0,0 +1,166 @@
+#include "autosave.h"
+
+// std
+#include <cstdio>
+#include <filesystem>
+
+// local
+#include "nodes_graph_settings.h"
+
+Autosave::~Autosave()
+{
+	Stop();
+}
+
+void Autosave::Start()
+{
+	if (_thread.joinable())
+		return;
+
+	_stop = false;
+	_thread = std::thread(&Autosave::Run, this);
+}
+
+void Autosave::Stop()
+{
+	if (!_thread.joinable())
+		return;
+
+	{
+		std::lock_guard lock(_mutex);
+		_stop = true;
+	}
+
+	_condition.notify_one();
+	_thread.join();
+}
+
+void Autosave::Update(NodesGraph* graph, const std::string& path, double idleSeconds)
+{
+	if (!NodesGraphSettings::AutosaveEnabled() || !_thread.joinable())
+		return;
+
+	auto& state = _graphs[graph];
+	auto now = std::chrono::steady_clock::now();
+
+	if (!graph->HasUnsavedChanges() || graph->GetChangeVersion() == state.savedVersion)
+		return;
+
+	if (now - state.lastSave < std::chrono::seconds(NodesGraphSettings::AutosaveInterval()))
+		return;
+
+	{
+		std::lock_guard lock(_mutex);
+		if (_isWriting || !_jobs.empty()) {
+			_metrics.throttled++;
+			return;
+		}
+	}
+
+	auto requiredIdle = state.snapshotMs * IdleSecondsPerSnapshotMs;
+	if (idleSeconds < (requiredIdle > MinimumIdleSeconds ? requiredIdle : MinimumIdleSeconds))
+		return;
+
+	auto start = std::chrono::steady_clock::now();
+	auto snapshot = graph->TakeSnapshot();
+	auto snapshotMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	state.lastSave = now;
+	state.savedVersion = graph->GetChangeVersion();
+	state.snapshotMs = snapshotMs;
+
+	{
+		std::lock_guard lock(_mutex);
+		_metrics.lastSnapshotMs = snapshotMs;
+		_metrics.maxSnapshotMs = snapshotMs > _metrics.maxSnapshotMs ? snapshotMs : _metrics.maxSnapshotMs;
+		_metrics.snapshots++;
+
+		_jobs.push_back({ path, std::move(snapshot), NodesGraphSettings::AutosaveBackups() });
+	}
+
+	_condition.notify_one();
+}
+
+void Autosave::Forget(NodesGraph* graph)
+{
+	_graphs.erase(graph);
+}
+
+AutosaveMetrics Autosave::GetMetrics()
+{
+	std::lock_guard lock(_mutex);
+	return _metrics;
+}
+
+std::string Autosave::GetBackupPath(const std::string& path, int index)
+{
+	return path + ".autosave." + std::to_string(index);
+}
+
+void Autosave::Run()
+{
+	while (true)
+	{
+		Job job;
+
+		{
+			std::unique_lock lock(_mutex);
+			_condition.wait(lock, [this] { return _stop || !_jobs.empty(); });
+
+			if (_jobs.empty())
+				break;
+
+			job = std::move(_jobs.front());
+			_jobs.pop_front();
+			_isWriting = true;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		auto data = job.snapshot.Serialize();
+		auto isWritten = Write(job.path, data, job.backups);
+		auto writeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		{
+			std::lock_guard lock(_mutex);
+			_isWriting = false;
+
+			_metrics.lastSize = data.size();
+
+			if (isWritten) {
+				_metrics.lastWriteMs = writeMs;
+				_metrics.maxWriteMs = writeMs > _metrics.maxWriteMs ? writeMs : _metrics.maxWriteMs;
+				_metrics.writes++;
+			}
+			else
+				_metrics.failures++;
+		}
+	}
+}
+
+bool Autosave::Write(const std::string& path, const std::string& data, int backups)
+{
+	// Write the new backup completely before rotating, so a failed write never costs an older one.
+	auto temporaryPath = path + ".autosave.tmp";
+
+	auto file = std::fopen(temporaryPath.c_str(), "wb");
+	if (file == nullptr)
+		return false;
+
+	auto isWritten = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+	isWritten = std::fclose(file) == 0 && isWritten;
+
+	if (!isWritten) {
+		std::remove(temporaryPath.c_str());
+		return false;
+	}
+
+	std::error_code error;
+	backups = backups > 0 ? backups : 1;
+
+	std::filesystem::remove(GetBackupPath(path, backups), error);
+	for (int i = backups - 1; i >= 1; i--)
+		std::filesystem::rename(GetBackupPath(path, i), GetBackupPath(path, i + 1), error);
+
+	std::filesystem::rename(temporaryPath, GetBackupPath(path, 1), error);
+	return !error;
+}
\ No newline at end of file
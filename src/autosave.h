@@ -0,0 +1,80 @@
+#pragma once
+
+// std
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+// local
+#include "nodes_graph.h"
+
+struct AutosaveMetrics {
+	double lastSnapshotMs = 0;
+	double maxSnapshotMs = 0;
+	double lastWriteMs = 0;
+	double maxWriteMs = 0;
+	size_t lastSize = 0;
+	uint64_t snapshots = 0;
+	uint64_t writes = 0;
+	uint64_t failures = 0;
+	uint64_t throttled = 0;
+};
+
+// Periodically writes unsaved graphs to rotating backup files next to them
+// (<path>.autosave.1 being the newest). Snapshots are taken on the UI thread,
+// the worker thread serializes and writes them.
+//
+// Snapshots are throttled: they are only taken once the user has been idle
+// for a while, that wait grows with the cost of the previous snapshot, and
+// no new snapshot is taken while the previous one is still being written.
+class Autosave {
+public:
+	~Autosave();
+
+	void Start();
+	void Stop();
+
+	// Called every frame for every open graph, `idleSeconds` is the time since the last user input.
+	void Update(NodesGraph* graph, const std::string& path, double idleSeconds);
+	void Forget(NodesGraph* graph);
+
+	AutosaveMetrics GetMetrics();
+
+	static std::string GetBackupPath(const std::string& path, int index);
+
+	inline static constexpr double MinimumIdleSeconds = 1.0;
+	// Required idle time per millisecond the previous snapshot took.
+	inline static constexpr double IdleSecondsPerSnapshotMs = 0.1;
+
+private:
+	struct GraphState {
+		std::chrono::steady_clock::time_point lastSave = std::chrono::steady_clock::now();
+		uint64_t savedVersion = 0;
+		double snapshotMs = 0;
+	};
+
+	struct Job {
+		std::string path;
+		GraphSnapshot snapshot;
+		int backups;
+	};
+
+	std::unordered_map<NodesGraph*, GraphState> _graphs;
+
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	std::deque<Job> _jobs;
+	bool _isWriting = false;
+	bool _stop = false;
+
+	AutosaveMetrics _metrics;
+
+	void Run();
+	bool Write(const std::string& path, const std::string& data, int backups);
+};
\ No newline at end of file
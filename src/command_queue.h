@@ -0,0 +1,106 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <cstddef>
+#include <thread>
+
+// local
+#include "commands.h"
+
+// Lock-free multi-producer/single-consumer queue of commands (intrusive
+// Vyukov queue). Any thread may Post, only the thread owning the graph may
+// Pop. Queued commands are deleted unexecuted if the queue is destroyed.
+//
+// Commands are constructed on the posting thread, so their constructors must
+// not read the graph (e.g. EditValueCommand reads the current value).
+class CommandQueue {
+private:
+	struct Item {
+		std::atomic<Item*> next = nullptr;
+		_Command* command = nullptr;
+	};
+
+	// Producers swap themselves in at the head, the consumer follows `next` from the tail.
+	std::atomic<Item*> _head;
+	Item* _tail;
+	Item _stub;
+
+	std::atomic<size_t> _size = 0;
+	size_t _capacity;
+
+	void Push(Item* item) {
+		item->next.store(nullptr, std::memory_order_relaxed);
+		auto previous = _head.exchange(item, std::memory_order_acq_rel);
+		previous->next.store(item, std::memory_order_release);
+	}
+
+public:
+	CommandQueue(size_t capacity = 4096) :
+		_head(&_stub),
+		_tail(&_stub),
+		_capacity(capacity)
+	{
+	}
+
+	~CommandQueue() {
+		while (auto command = Pop())
+			delete command;
+	}
+
+	CommandQueue(const CommandQueue&) = delete;
+	CommandQueue& operator=(const CommandQueue&) = delete;
+
+	// Fails when the queue is full, the caller keeps ownership of the command then.
+	bool TryPost(_Command* command) {
+		if (_size.fetch_add(1, std::memory_order_acq_rel) >= _capacity) {
+			_size.fetch_sub(1, std::memory_order_acq_rel);
+			return false;
+		}
+
+		auto item = new Item();
+		item->command = command;
+		Push(item);
+		return true;
+	}
+
+	// Waits for the consumer to make room, never call it from the consumer thread.
+	void Post(_Command* command) {
+		while (!TryPost(command))
+			std::this_thread::yield();
+	}
+
+	// Returns nullptr when the queue is empty, or while a producer is half way through a push.
+	_Command* Pop() {
+		auto tail = _tail;
+		auto next = tail->next.load(std::memory_order_acquire);
+
+		if (tail == &_stub) {
+			if (next == nullptr) return nullptr;
+
+			_tail = next;
+			tail = next;
+			next = next->next.load(std::memory_order_acquire);
+		}
+
+		if (next == nullptr) {
+			if (tail != _head.load(std::memory_order_acquire)) return nullptr;
+
+			Push(&_stub);
+			next = tail->next.load(std::memory_order_acquire);
+			if (next == nullptr) return nullptr;
+		}
+
+		_tail = next;
+
+		auto command = tail->command;
+		delete tail;
+
+		_size.fetch_sub(1, std::memory_order_acq_rel);
+		return command;
+	}
+
+	inline size_t Size() const { return _size.load(std::memory_order_relaxed); }
+	inline size_t Capacity() const { return _capacity; }
+	inline bool IsFull() const { return Size() >= _capacity; }
+};
\ No newline at end of file
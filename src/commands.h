@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <cstddef>
 #include <stack>
 #include <vector>
 
@@ -15,13 +17,24 @@ protected:
 	virtual void _Undo() = 0;
 	virtual void _Redo() = 0;
 
+	// Bytes retained by the command in its current state, including any
+	// objects it owns (e.g. a deleted node kept alive for undo).
+	virtual size_t _GetMemoryUsage() const { return sizeof(_Command); }
+
+	// Coalescing: a command that targets the same thing as an already executed
+	// one can be folded into it, so only the first keeps its undo state.
+	virtual bool _CanMerge(const _Command* next) const { return false; }
+	virtual void _Merge(_Command* next) {}
+
 	const char* _label;
 	CommandState _state;
+	std::chrono::steady_clock::time_point _time;
 
 public:
 	_Command(const char* label) :
 		_label(label),
-		_state(Created)
+		_state(Created),
+		_time(std::chrono::steady_clock::now())
 	{
 	}
 
@@ -49,6 +62,24 @@ public:
 	const CommandState GetState() const {
 		return _state;
 	}
+
+	size_t GetMemoryUsage() const {
+		return _GetMemoryUsage();
+	}
+
+	bool CanMerge(const _Command* next) const {
+		return _CanMerge(next);
+	}
+
+	// Takes over the result of an executed `next`; `next` can be deleted after.
+	void Merge(_Command* next) {
+		_Merge(next);
+		_time = next->_time;
+	}
+
+	std::chrono::steady_clock::time_point GetTime() const {
+		return _time;
+	}
 };
 
 class CommandCluster : public _Command {
@@ -62,8 +93,8 @@ private:
 	}
 
 	void _Undo() override {
-		for (const auto& command : _commands) {
-			command->Undo();
+		for (auto it = _commands.rbegin(); it != _commands.rend(); ++it) {
+			(*it)->Undo();
 		}
 	}
 
@@ -73,6 +104,33 @@ private:
 		}
 	}
 
+	size_t _GetMemoryUsage() const override {
+		auto usage = sizeof(*this) + _commands.capacity() * sizeof(_Command*);
+		for (const auto& command : _commands) {
+			usage += command->GetMemoryUsage();
+		}
+		return usage;
+	}
+
+	bool _CanMerge(const _Command* next) const override {
+		auto cluster = dynamic_cast<const CommandCluster*>(next);
+		if (cluster == nullptr || cluster->_commands.size() != _commands.size())
+			return false;
+
+		for (size_t i = 0; i < _commands.size(); i++) {
+			if (!_commands[i]->CanMerge(cluster->_commands[i]))
+				return false;
+		}
+		return true;
+	}
+
+	void _Merge(_Command* next) override {
+		auto cluster = static_cast<CommandCluster*>(next);
+		for (size_t i = 0; i < _commands.size(); i++) {
+			_commands[i]->Merge(cluster->_commands[i]);
+		}
+	}
+
 public:
 	CommandCluster(const char* label) : _Command(label) {}
 
@@ -94,6 +152,32 @@ private:
 
 	int _commandIndex = 0;
 
+	// Running total of GetMemoryUsage() over both stacks, adjusted whenever a
+	// command changes state.
+	size_t _memoryUsage = 0;
+
+	// Commands executed within this window of the previous one are merged into
+	// it when they target the same thing. Sealing stops merging into the
+	// current top, e.g. once the graph has been saved at that point.
+	std::chrono::milliseconds _mergeWindow = std::chrono::milliseconds(1000);
+	_Command* _sealedCommand = nullptr;
+
+	bool TryMerge(_Command* command) {
+		if (_undoStack.empty() || !_redoStack.empty()) return false;
+
+		auto previous = _undoStack.back();
+		if (previous == _sealedCommand) return false;
+		if (command->GetTime() - previous->GetTime() > _mergeWindow) return false;
+		if (!previous->CanMerge(command)) return false;
+
+		_memoryUsage -= previous->GetMemoryUsage();
+		previous->Merge(command);
+		_memoryUsage += previous->GetMemoryUsage();
+
+		delete command;
+		return true;
+	}
+
 public:
 	std::vector<_Command*>& GetUndoStack()
 	{
@@ -107,9 +191,14 @@ public:
 
 	void Execute(_Command* command) {
 		command->Execute();
+		if (TryMerge(command)) return;
+
 		_undoStack.push_back(command);
+		_memoryUsage += command->GetMemoryUsage();
 
 		for (auto& it : _redoStack) {
+			if (it == _sealedCommand) _sealedCommand = nullptr;
+			_memoryUsage -= it->GetMemoryUsage();
 			delete it;
 		}
 
@@ -122,7 +211,9 @@ public:
 		if (!HasUndo()) return;
 
 		auto undoCommand = _undoStack.back();
+		_memoryUsage -= undoCommand->GetMemoryUsage();
 		undoCommand->Undo();
+		_memoryUsage += undoCommand->GetMemoryUsage();
 
 		_redoStack.push_back(undoCommand);
 		_undoStack.erase(_undoStack.end() - 1);
@@ -134,7 +225,9 @@ public:
 		if (!HasRedo()) return;
 
 		auto redoCommand = _redoStack.back();
+		_memoryUsage -= redoCommand->GetMemoryUsage();
 		redoCommand->Redo();
+		_memoryUsage += redoCommand->GetMemoryUsage();
 
 		_undoStack.push_back(redoCommand);
 		_redoStack.erase(_redoStack.end() - 1);
@@ -154,6 +247,40 @@ public:
 		return _commandIndex;
 	}
 
+	size_t GetMemoryUsage() const {
+		return _memoryUsage;
+	}
+
+	void SetMergeWindow(std::chrono::milliseconds window) {
+		_mergeWindow = window;
+	}
+
+	void Seal() {
+		_sealedCommand = _undoStack.empty() ? nullptr : _undoStack.back();
+	}
+
+	// Drops the oldest undoable commands until the history fits in the budget
+	// (0 means unlimited). The most recent command is always kept. Evicted
+	// commands are executed, so deleting them only frees what they own in that
+	// state (e.g. nodes removed by a delete), never objects still in the graph.
+	// Returns the number of evicted commands.
+	size_t Trim(size_t maxBytes, size_t maxCommands) {
+		size_t count = 0;
+		while (count + 1 < _undoStack.size()) {
+			bool overBytes = maxBytes > 0 && _memoryUsage > maxBytes;
+			bool overCount = maxCommands > 0 && _undoStack.size() - count > maxCommands;
+			if (!overBytes && !overCount) break;
+
+			if (_undoStack[count] == _sealedCommand) _sealedCommand = nullptr;
+			_memoryUsage -= _undoStack[count]->GetMemoryUsage();
+			delete _undoStack[count];
+			count++;
+		}
+
+		_undoStack.erase(_undoStack.begin(), _undoStack.begin() + count);
+		return count;
+	}
+
 	void Clear() {
 		for (const auto& command : _redoStack) {
 			delete command;
@@ -162,5 +289,10 @@ public:
 		for (const auto& command : _undoStack) {
 			delete command;
 		}
+
+		_redoStack.clear();
+		_undoStack.clear();
+		_memoryUsage = 0;
+		_sealedCommand = nullptr;
 	}
 };
\ No newline at end of file
@@ -1,11 +1,12 @@
 #pragma once
 #include "../commands.h"
-#include "../node.h"
+#include "../nodes_graph.h"
 
 class CreateChildNodeCommand : public _Command {
 private:
 	Node* _node;
-	std::vector<Node*>* _vector;
+	_GroupNode* _parent;
+	NodesGraph* _graph;
 
 public:
 	~CreateChildNodeCommand() {
@@ -13,23 +14,28 @@ public:
 			delete _node;
 	}
 
-	CreateChildNodeCommand(Node* node, std::vector<Node*>* vector) :
+	CreateChildNodeCommand(Node* node, _GroupNode* parent, NodesGraph* graph) :
 		_Command("Create Child Node"),
 		_node(node),
-		_vector(vector)
+		_parent(parent),
+		_graph(graph)
 	{
 	}
 
 protected:
 	void _Execute() override {
-		_vector->emplace_back(_node);
+		_graph->InsertChildNode(_parent, _node, _parent->GetNodes().size());
 	}
 
 	void _Undo() override {
-		_vector->erase(_vector->end() - 1);
+		_graph->RemoveChildNode(_parent, _node);
 	}
 
 	void _Redo() override {
-		_vector->emplace_back(_node);
+		_graph->InsertChildNode(_parent, _node, _parent->GetNodes().size());
+	}
+
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this) + (_state == Reverted ? _node->GetMemoryUsage() : 0);
 	}
 };
\ No newline at end of file
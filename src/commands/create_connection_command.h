@@ -1,13 +1,10 @@
 #include "../commands.h"
-#include "../node_connection.h"
-
-#include <map>
-#include <string>
+#include "../nodes_graph.h"
 
 class CreateConnectionCommand : public _Command {
 private:
 	NodeConnection* _connection;
-	std::map<std::string, NodeConnection*>* _map;
+	NodesGraph* _graph;
 
 public:
 	~CreateConnectionCommand() {
@@ -15,28 +12,26 @@ public:
 			delete _connection;
 	}
 
-	CreateConnectionCommand(NodeConnection* connection, std::map<std::string, NodeConnection*>* map) :
+	CreateConnectionCommand(NodeConnection* connection, NodesGraph* graph) :
 		_Command("Create Connection"),
-		_connection(connection), _map(map)
+		_connection(connection), _graph(graph)
 	{
 	}
 
 protected:
 	void _Execute() override {
-		_map->emplace(_connection->GetId(), _connection);
-		_connection->GetFrom()->AddConnectionFrom();
-		_connection->GetTo()->AddConnectionTo();
+		_graph->AddConnection(_connection);
 	}
 
 	void _Undo() override {
-		_map->erase(_connection->GetId());
-		_connection->GetFrom()->RemoveConnectionFrom();
-		_connection->GetTo()->RemoveConnectionTo();
+		_graph->RemoveConnection(_connection);
 	}
 
 	void _Redo() override {
-		_map->emplace(_connection->GetId(), _connection);
-		_connection->GetFrom()->AddConnectionFrom();
-		_connection->GetTo()->AddConnectionTo();
+		_graph->AddConnection(_connection);
+	}
+
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this) + (_state != Executed ? sizeof(NodeConnection) : 0);
 	}
 };
\ No newline at end of file
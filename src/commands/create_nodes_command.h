@@ -0,0 +1,57 @@
+#pragma once
+#include <vector>
+
+#include "../commands.h"
+#include "../nodes_graph.h"
+
+class CreateNodesCommand : public _Command {
+private:
+	std::vector<Node*> _nodes;
+	std::vector<NodeConnection*> _connections;
+	NodesGraph* _graph;
+
+public:
+	~CreateNodesCommand() {
+		if (_state == Reverted || _state == Created) {
+			for (auto connection : _connections)
+				delete connection;
+
+			for (auto node : _nodes)
+				delete node;
+		}
+	}
+
+	CreateNodesCommand(std::vector<Node*> nodes, std::vector<NodeConnection*> connections, NodesGraph* graph, const char* label = "Create Nodes") :
+		_Command(label),
+		_nodes(std::move(nodes)),
+		_connections(std::move(connections)),
+		_graph(graph)
+	{
+	}
+
+protected:
+	void _Execute() override {
+		_graph->AddNodes(_nodes, _connections);
+	}
+
+	void _Undo() override {
+		_graph->RemoveNodes(_nodes, _connections);
+	}
+
+	void _Redo() override {
+		_graph->AddNodes(_nodes, _connections);
+	}
+
+	size_t _GetMemoryUsage() const override {
+		size_t size = sizeof(*this) + (_nodes.capacity() + _connections.capacity()) * sizeof(void*);
+
+		if (_state != Executed) {
+			for (auto node : _nodes)
+				size += node->GetMemoryUsage();
+
+			size += _connections.size() * sizeof(NodeConnection);
+		}
+
+		return size;
+	}
+};
\ No newline at end of file
@@ -1,11 +1,12 @@
 #pragma once
 #include "../commands.h"
-#include "../node.h"
+#include "../nodes_graph.h"
 
 class DeleteChildNodeCommand : public _Command {
 private:
 	Node* _node;
-	std::vector<Node*>* _vector;
+	_GroupNode* _parent;
+	NodesGraph* _graph;
 	size_t _index;
 
 public:
@@ -14,26 +15,29 @@ public:
 			delete _node;
 	}
 
-	DeleteChildNodeCommand(Node* node, std::vector<Node*>* vector) :
+	DeleteChildNodeCommand(Node* node, _GroupNode* parent, NodesGraph* graph) :
 		_Command("Delete Child Node"),
 		_index(0),
 		_node(node),
-		_vector(vector)
+		_parent(parent),
+		_graph(graph)
 	{
 	}
 
 protected:
 	void _Execute() override {
-		auto it = std::find(_vector->begin(), _vector->end(), _node);
-		_index = std::distance(_vector->begin(), it);
-		_vector->erase(it);
+		_index = _graph->RemoveChildNode(_parent, _node);
 	}
 
 	void _Undo() override {
-		_vector->insert(_vector->begin() + _index, _node);
+		_graph->InsertChildNode(_parent, _node, _index);
 	}
 
 	void _Redo() override {
-		_vector->erase(_vector->begin() + _index);
+		_graph->RemoveChildNode(_parent, _node);
+	}
+
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this) + (_state == Executed ? _node->GetMemoryUsage() : 0);
 	}
 };
\ No newline at end of file
@@ -1,11 +1,11 @@
 #pragma once
 #include "../commands.h"
-#include "../node.h"
+#include "../nodes_graph.h"
 
 class DeleteNodeCommand : public _Command {
 private:
 	Node* _node;
-	std::map<std::string, Node*>* _map;
+	NodesGraph* _graph;
 
 public:
 	~DeleteNodeCommand() {
@@ -13,23 +13,27 @@ public:
 			delete _node;
 	}
 
-	DeleteNodeCommand(Node* node, std::map<std::string, Node*>* map) :
+	DeleteNodeCommand(Node* node, NodesGraph* graph) :
 		_Command("Delete Node"),
 		_node(node),
-		_map(map)
+		_graph(graph)
 	{
 	}
 
 protected:
 	void _Execute() override {
-		_map->erase(_node->GetId());
+		_graph->RemoveNode(_node);
 	}
 
 	void _Undo() override {
-		_map->emplace(_node->GetId(), _node);
+		_graph->AddNode(_node);
 	}
 
 	void _Redo() override {
-		_map->erase(_node->GetId());
+		_graph->RemoveNode(_node);
+	}
+
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this) + (_state == Executed ? _node->GetMemoryUsage() : 0);
 	}
 };
\ No newline at end of file
@@ -1,19 +1,18 @@
 #include "../commands.h"
-#include "../node_connection.h"
-
-#include <map>
-#include <string>
+#include "../nodes_graph.h"
 
 class EditConnectionCommand : public _Command {
 private:
 	NodeConnection* _connection;
+	NodesGraph* _graph;
 	NodeSlot* _fromPrev, * _fromCurr;
 	NodeSlot* _toPrev, * _toCurr;
 
 public:
-	EditConnectionCommand(NodeConnection* connection, NodeSlot* from, NodeSlot* to) :
+	EditConnectionCommand(NodeConnection* connection, NodeSlot* from, NodeSlot* to, NodesGraph* graph) :
 		_Command("Edit Connection"),
 		_connection(connection),
+		_graph(graph),
 		_fromCurr(from),
 		_toCurr(to)
 	{
@@ -23,44 +22,18 @@ public:
 
 protected:
 	void _Execute() override {
-		if (_fromPrev != _fromCurr) {
-			_connection->SetFrom(_fromCurr);
-			_fromPrev->RemoveConnectionFrom();
-			_fromCurr->AddConnectionFrom();
-		}
-
-		if (_toPrev != _toCurr) {
-			_connection->SetTo(_toCurr);
-			_toPrev->RemoveConnectionTo();
-			_toCurr->AddConnectionTo();
-		}
+		_graph->SetConnectionSlots(_connection, _fromCurr, _toCurr);
 	}
 
 	void _Undo() override {
-		if (_fromPrev != _fromCurr) {
-			_connection->SetFrom(_fromPrev);
-			_fromCurr->RemoveConnectionFrom();
-			_fromPrev->AddConnectionFrom();
-		}
-
-		if (_toPrev != _toCurr) {
-			_connection->SetTo(_toPrev);
-			_toCurr->RemoveConnectionTo();
-			_toPrev->AddConnectionTo();
-		}
+		_graph->SetConnectionSlots(_connection, _fromPrev, _toPrev);
 	}
 
 	void _Redo() override {
-		if (_fromPrev != _fromCurr) {
-			_connection->SetFrom(_fromCurr);
-			_fromPrev->RemoveConnectionFrom();
-			_fromCurr->AddConnectionFrom();
-		}
+		_graph->SetConnectionSlots(_connection, _fromCurr, _toCurr);
+	}
 
-		if (_toPrev != _toCurr) {
-			_connection->SetTo(_toCurr);
-			_toPrev->RemoveConnectionTo();
-			_toCurr->AddConnectionTo();
-		}
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+#include "../commands.h"
+#include "../nodes_graph.h"
+#include "../subgraph_node.h"
+
+// The edits made inside an entered subgraph, recorded in the parent graph as
+// one change of the subgraph node. Undoing drops the loaded inner graph, it is
+// loaded again from the restored contents when needed.
+class EditSubgraphCommand : public _Command {
+private:
+	SubgraphNode* _node;
+	SubgraphContents _previous;
+	SubgraphContents _current;
+	NodesGraph* _graph;
+
+public:
+	EditSubgraphCommand(SubgraphNode* node, SubgraphContents contents, NodesGraph* graph) :
+		_Command("Edit Subgraph"),
+		_node(node),
+		_previous(node->GetContents()),
+		_current(std::move(contents)),
+		_graph(graph)
+	{
+	}
+
+protected:
+	void _Execute() override {
+		// The contents were just taken from the loaded graph, it stays.
+		_node->SetContents(_current, true);
+		_graph->OnNodeChanged(_node);
+	}
+
+	void _Undo() override {
+		_node->SetContents(_previous);
+		_graph->OnNodeChanged(_node);
+	}
+
+	void _Redo() override {
+		_node->SetContents(_current);
+		_graph->OnNodeChanged(_node);
+	}
+
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this) + _previous.data.capacity() + _current.data.capacity();
+	}
+
+	bool _CanMerge(const _Command* next) const override {
+		auto edit = dynamic_cast<const EditSubgraphCommand*>(next);
+		return edit != nullptr && edit->_node == _node;
+	}
+
+	void _Merge(_Command* next) override {
+		_current = std::move(static_cast<EditSubgraphCommand*>(next)->_current);
+	}
+};
\ No newline at end of file
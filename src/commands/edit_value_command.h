@@ -1,5 +1,9 @@
 #pragma once
 #include "../commands.h"
+#include "../nodes_graph.h"
+
+#include <string>
+#include <type_traits>
 
 template<typename T>
 class EditValueCommand : public _Command {
@@ -8,24 +12,65 @@ private:
   T _valueCurrent;
   T* _valuePtr;
 
+  // The node or connection owning the value, if any, is reported back to the graph after every change.
+  Node* _node;
+  NodeConnection* _connection;
+  NodesGraph* _graph;
+
 public:
-  EditValueCommand(T* valuePtr, T valuePrevious) : _Command("Edit Value")
+  EditValueCommand(T* valuePtr, T valuePrevious, NodesGraph* graph = nullptr, Node* node = nullptr) : _Command("Edit Value")
   {
     _valuePrevious = valuePrevious;
     _valueCurrent = *valuePtr;
     _valuePtr = valuePtr;
+    _graph = graph;
+    _node = node;
+    _connection = nullptr;
+  }
+
+  EditValueCommand(T* valuePtr, T valuePrevious, NodesGraph* graph, NodeConnection* connection) :
+    EditValueCommand(valuePtr, valuePrevious, graph)
+  {
+    _connection = connection;
   }
 
 protected:
 	void _Execute() override {
 		*_valuePtr = _valueCurrent;
+		NotifyChanged();
 	}
 
 	void _Undo() override {
 		*_valuePtr = _valuePrevious;
+		NotifyChanged();
 	}
 
 	void _Redo() override {
 		*_valuePtr = _valueCurrent;
+		NotifyChanged();
+	}
+
+	size_t _GetMemoryUsage() const override {
+		if constexpr (std::is_same_v<T, std::string>)
+			return sizeof(*this) + _valuePrevious.capacity() + _valueCurrent.capacity();
+		else
+			return sizeof(*this);
+	}
+
+	bool _CanMerge(const _Command* next) const override {
+		auto edit = dynamic_cast<const EditValueCommand<T>*>(next);
+		return edit != nullptr && edit->_valuePtr == _valuePtr;
+	}
+
+	void _Merge(_Command* next) override {
+		_valueCurrent = std::move(static_cast<EditValueCommand<T>*>(next)->_valueCurrent);
+	}
+
+private:
+	void NotifyChanged() {
+		if (_graph && _node)
+			_graph->OnNodeChanged(_node);
+		if (_graph && _connection)
+			_graph->OnConnectionChanged(_connection);
 	}
 };
\ No newline at end of file
@@ -1,6 +1,6 @@
 #pragma once
 #include "../commands.h"
-#include "../node.h"
+#include "../nodes_graph.h"
 
 class MoveChildNodeCommand : public _Command {
 private:
@@ -8,25 +8,39 @@ private:
 	std::vector<Node*>& _vector;
 	int _indexFrom;
 	int _indexTo;
+	NodesGraph* _graph;
 
 public:
-	MoveChildNodeCommand(Node* node, std::vector<Node*>& vector, int indexFrom, int indexTo)
-		: _Command("Move Child Node"), _node(node), _vector(vector), _indexFrom(indexFrom), _indexTo(indexTo) {
+	MoveChildNodeCommand(Node* node, std::vector<Node*>& vector, int indexFrom, int indexTo, NodesGraph* graph = nullptr)
+		: _Command("Move Child Node"), _node(node), _vector(vector), _indexFrom(indexFrom), _indexTo(indexTo), _graph(graph) {
 	}
 
 protected:
 	void _Execute() override {
 		_vector.erase(_vector.begin() + _indexFrom);
 		_vector.insert(_vector.begin() + _indexTo, _node);
+		NotifyChanged();
 	}
 
 	void _Undo() override {
 		_vector.erase(_vector.begin() + _indexTo);
 		_vector.insert(_vector.begin() + _indexFrom, _node);
+		NotifyChanged();
 	}
 
 	void _Redo() override {
 		_vector.erase(_vector.begin() + _indexFrom);
 		_vector.insert(_vector.begin() + _indexTo, _node);
+		NotifyChanged();
+	}
+
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this);
+	}
+
+private:
+	void NotifyChanged() {
+		if (_graph)
+			_graph->OnNodeChanged(_node);
 	}
 };
\ No newline at end of file
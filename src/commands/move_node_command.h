@@ -1,19 +1,21 @@
 #pragma once
 #include "../commands.h"
-#include "../node.h"
+#include "../nodes_graph.h"
 
 class MoveNodeCommand : public _Command {
 private:
 	Node* _node;
 	ImVec2 _positionFrom;
 	ImVec2 _positionTo;
+	NodesGraph* _graph;
 
 public:
 
-	MoveNodeCommand(Node* node, ImVec2 positionTo) :
+	MoveNodeCommand(Node* node, ImVec2 positionTo, NodesGraph* graph = nullptr) :
 		_Command("Move Node"),
 		_node(node),
-		_positionTo(positionTo)
+		_positionTo(positionTo),
+		_graph(graph)
 	{
 		_positionFrom = node->GetRecordedPosition();
 	}
@@ -22,15 +24,37 @@ protected:
 	void _Execute() override {
 		_node->SetPosition(_positionTo);
 		_node->SetRecordedPosition(_positionTo);
+		NotifyChanged();
 	}
 
 	void _Undo() override {
 		_node->SetPosition(_positionFrom);
 		_node->SetRecordedPosition(_positionFrom);
+		NotifyChanged();
 	}
 
 	void _Redo() override {
 		_node->SetPosition(_positionTo);
 		_node->SetRecordedPosition(_positionTo);
+		NotifyChanged();
+	}
+
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this);
+	}
+
+	bool _CanMerge(const _Command* next) const override {
+		auto move = dynamic_cast<const MoveNodeCommand*>(next);
+		return move != nullptr && move->_node == _node;
+	}
+
+	void _Merge(_Command* next) override {
+		_positionTo = static_cast<MoveNodeCommand*>(next)->_positionTo;
+	}
+
+private:
+	void NotifyChanged() {
+		if (_graph)
+			_graph->OnNodeMoved(_node);
 	}
 };
\ No newline at end of file
@@ -0,0 +1,74 @@
+#pragma once
+#include <cstring>
+#include <vector>
+
+#include "../commands.h"
+#include "../nodes_graph.h"
+
+// Moves a set of nodes as one undo step. The offsets are kept in a single
+// array parallel to the nodes and applied to the recorded positions, so nodes
+// that were already dragged on screen end up where they are.
+class MoveNodesCommand : public _Command {
+private:
+	std::vector<Node*> _nodes;
+	std::vector<ImVec2> _deltas;
+	NodesGraph* _graph;
+
+public:
+	// Only drags merge, align/distribute/pack stay separate undo steps.
+	inline static constexpr const char* DragLabel = "Move Nodes";
+
+	MoveNodesCommand(std::vector<Node*> nodes, std::vector<ImVec2> deltas, NodesGraph* graph = nullptr, const char* label = DragLabel) :
+		_Command(label),
+		_nodes(std::move(nodes)),
+		_deltas(std::move(deltas)),
+		_graph(graph)
+	{
+	}
+
+protected:
+	void _Execute() override {
+		Apply(1.0f);
+	}
+
+	void _Undo() override {
+		Apply(-1.0f);
+	}
+
+	void _Redo() override {
+		Apply(1.0f);
+	}
+
+	size_t _GetMemoryUsage() const override {
+		return sizeof(*this) + _nodes.capacity() * sizeof(Node*) + _deltas.capacity() * sizeof(ImVec2);
+	}
+
+	bool _CanMerge(const _Command* next) const override {
+		auto move = dynamic_cast<const MoveNodesCommand*>(next);
+		return move != nullptr && IsDrag() && move->IsDrag() && move->_nodes == _nodes;
+	}
+
+	void _Merge(_Command* next) override {
+		auto& deltas = static_cast<MoveNodesCommand*>(next)->_deltas;
+		for (size_t i = 0; i < _deltas.size(); i++)
+			_deltas[i] += deltas[i];
+	}
+
+private:
+	bool IsDrag() const {
+		return std::strcmp(_label, DragLabel) == 0;
+	}
+
+	void Apply(float direction) {
+		for (size_t i = 0; i < _nodes.size(); i++) {
+			auto node = _nodes[i];
+			auto position = node->GetRecordedPosition() + _deltas[i] * direction;
+
+			node->SetPosition(position);
+			node->SetRecordedPosition(position);
+
+			if (_graph)
+				_graph->OnNodeMoved(node);
+		}
+	}
+};
\ No newline at end of file
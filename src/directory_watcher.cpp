@@ -0,0 +1,83 @@
+#include "directory_watcher.h"
+
+#if defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+	Stop();
+}
+
+#if defined(__linux__)
+bool DirectoryWatcher::Start(const std::string& directory)
+{
+	Stop();
+
+	_handle = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (_handle < 0)
+		return false;
+
+	_watch = inotify_add_watch(_handle, directory.c_str(), IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO);
+	if (_watch < 0) {
+		Stop();
+		return false;
+	}
+
+	return true;
+}
+
+void DirectoryWatcher::Stop()
+{
+	if (_handle >= 0)
+		close(_handle);
+
+	_handle = -1;
+	_watch = -1;
+}
+
+bool DirectoryWatcher::Poll(std::vector<std::string>& names)
+{
+	if (_handle < 0)
+		return false;
+
+	alignas(inotify_event) char buffer[16 * 1024];
+	while (true)
+	{
+		auto length = read(_handle, buffer, sizeof(buffer));
+		if (length < 0)
+			return errno == EAGAIN || errno == EINTR;
+
+		if (length == 0)
+			return true;
+
+		for (char* position = buffer; position < buffer + length; )
+		{
+			auto event = (inotify_event*)position;
+			position += sizeof(inotify_event) + event->len;
+
+			if (event->mask & (IN_Q_OVERFLOW | IN_IGNORED))
+				return false;
+
+			if (event->len > 0)
+				names.emplace_back(event->name);
+		}
+	}
+}
+#else
+bool DirectoryWatcher::Start(const std::string& directory)
+{
+	return false;
+}
+
+void DirectoryWatcher::Stop()
+{
+}
+
+bool DirectoryWatcher::Poll(std::vector<std::string>& names)
+{
+	return false;
+}
+#endif
\ No newline at end of file
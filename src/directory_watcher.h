@@ -0,0 +1,27 @@
+#pragma once
+
+// std
+#include <string>
+#include <vector>
+
+// Reports the files of a directory that were written, created, removed or
+// renamed. Uses inotify on Linux; elsewhere nothing is watched and Poll
+// always asks for a rescan.
+class DirectoryWatcher {
+public:
+	~DirectoryWatcher();
+
+	// False if the directory can't be watched.
+	bool Start(const std::string& directory);
+	void Stop();
+
+	inline bool IsWatching() const { return _handle >= 0; }
+
+	// Adds the names of the files changed since the last call. Returns false if
+	// changes may have been missed, then the whole directory has to be rescanned.
+	bool Poll(std::vector<std::string>& names);
+
+private:
+	int _handle = -1;
+	int _watch = -1;
+};
\ No newline at end of file
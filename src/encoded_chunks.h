@@ -0,0 +1,159 @@
+#pragma once
+
+// std
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// FNV-1a, chained through `hash` to combine several strings. Unlike
+// std::hash the result is the same on every platform, so it can be saved.
+inline uint64_t HashEncoded(const std::string& data, uint64_t hash = 14695981039346656037ull) {
+	for (auto c : data) {
+		hash ^= (unsigned char)c;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// Appends the hash of a child to the hash of its parent (see EncodedChunk::hash).
+inline uint64_t CombineHash(uint64_t hash, uint64_t value) {
+	for (int i = 0; i < 8; i++) {
+		hash ^= (value >> (i * 8)) & 0xFF;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+// 16 hex digits, as the hash is written to files.
+inline std::string FormatHash(uint64_t hash) {
+	char text[17];
+	snprintf(text, sizeof(text), "%016llx", (unsigned long long)hash);
+	return text;
+}
+
+// Encoded JSON of a single node or connection. Published records and chunks
+// are immutable, so they can be shared with snapshots read by other threads.
+struct EncodedRecord {
+	std::string id;
+	std::string encoded;
+	uint64_t hash;
+};
+
+struct EncodedChunk {
+	std::map<std::string, std::shared_ptr<const EncodedRecord>> records;
+	// The records joined with ",\n".
+	std::string encoded;
+	// The hashes of the records combined in order, so only changed records are hashed again.
+	uint64_t hash = HashEncoded(std::string());
+};
+
+inline constexpr size_t EncodedChunkCount = 128;
+
+// Stable across platforms, the chunk hashes are part of the saved content hash.
+inline size_t GetEncodedChunkIndex(const std::string& id) {
+	return HashEncoded(id) % EncodedChunkCount;
+}
+using EncodedChunkArray = std::array<std::shared_ptr<const EncodedChunk>, EncodedChunkCount>;
+
+// Caches the encoded text of a set of objects (nodes or connections) for
+// serialization. Objects are spread over a fixed number of chunks by id.
+// Changes are only recorded until the next Publish, which re-encodes the
+// changed objects and replaces their chunks. Chunks still referenced by a
+// snapshot are copied first (copy-on-write), others are updated in place.
+template<typename T>
+class EncodedChunks {
+public:
+	using Encoder = std::function<std::string(T*)>;
+
+	EncodedChunks() {
+		Clear();
+	}
+
+	void Clear() {
+		for (size_t i = 0; i < EncodedChunkCount; i++) {
+			_chunks[i] = std::make_shared<const EncodedChunk>();
+			_changes[i].clear();
+		}
+	}
+
+	// Adds the object or marks it as changed.
+	void Set(const std::string& id, T* object) {
+		_changes[GetEncodedChunkIndex(id)][id] = object;
+	}
+
+	void Remove(const std::string& id) {
+		_changes[GetEncodedChunkIndex(id)][id] = nullptr;
+	}
+
+	// Replaces all objects with records that are already encoded, e.g. the
+	// lines of a saved document, their hashes are computed here.
+	void Reset(std::vector<EncodedRecord>&& encoded) {
+		std::array<std::shared_ptr<EncodedChunk>, EncodedChunkCount> chunks;
+		for (auto& chunk : chunks)
+			chunk = std::make_shared<EncodedChunk>();
+
+		for (auto& record : encoded) {
+			record.hash = HashEncoded(record.encoded);
+			auto& records = chunks[GetEncodedChunkIndex(record.id)]->records;
+			auto id = record.id;
+			records[id] = std::make_shared<const EncodedRecord>(std::move(record));
+		}
+
+		for (size_t i = 0; i < EncodedChunkCount; i++) {
+			Join(*chunks[i]);
+			_chunks[i] = chunks[i];
+			_changes[i].clear();
+		}
+	}
+
+	// Applies the recorded changes and returns the current chunks.
+	const EncodedChunkArray& Publish(const Encoder& encode) {
+		for (size_t i = 0; i < EncodedChunkCount; i++) {
+			auto& changes = _changes[i];
+			if (changes.empty()) continue;
+
+			std::shared_ptr<EncodedChunk> chunk;
+			if (_chunks[i].use_count() == 1)
+				chunk = std::const_pointer_cast<EncodedChunk>(_chunks[i]);
+			else
+				chunk = std::make_shared<EncodedChunk>(*_chunks[i]);
+
+			for (const auto& [id, object] : changes) {
+				if (object == nullptr)
+					chunk->records.erase(id);
+				else {
+					auto encoded = encode(object);
+					auto hash = HashEncoded(encoded);
+					chunk->records[id] = std::make_shared<const EncodedRecord>(EncodedRecord{ id, std::move(encoded), hash });
+				}
+			}
+
+			Join(*chunk);
+			_chunks[i] = chunk;
+			changes.clear();
+		}
+
+		return _chunks;
+	}
+
+private:
+	EncodedChunkArray _chunks;
+	std::array<std::map<std::string, T*>, EncodedChunkCount> _changes;
+
+	static void Join(EncodedChunk& chunk) {
+		chunk.encoded.clear();
+		chunk.hash = HashEncoded(std::string());
+		for (const auto& [_, record] : chunk.records) {
+			if (!chunk.encoded.empty()) chunk.encoded += ",\n";
+			chunk.encoded += record->encoded;
+			chunk.hash = CombineHash(chunk.hash, record->hash);
+		}
+	}
+};
\ No newline at end of file
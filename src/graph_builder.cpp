@@ -0,0 +1,86 @@
+#include "graph_builder.h"
+
+// commands
+#include "commands/create_nodes_command.h"
+
+GraphBuilder::GraphBuilder(NodesGraph* graph) :
+	_graph(graph)
+{
+}
+
+GraphBuilder::~GraphBuilder()
+{
+	Clear();
+}
+
+void GraphBuilder::Reserve(size_t nodeCount, size_t connectionCount)
+{
+	_nodes.reserve(nodeCount);
+	_connections.reserve(connectionCount);
+}
+
+int GraphBuilder::AddNode(const std::string& type, const ImVec2& position)
+{
+	return AddNode(NodesGraph::FindNodeType(type), position);
+}
+
+int GraphBuilder::AddNode(int typeId, const ImVec2& position)
+{
+	auto nodeType = NodesGraph::GetNodeType(typeId);
+	if (nodeType == nullptr)
+		return -1;
+
+	return AddNode(nodeType->create(position));
+}
+
+int GraphBuilder::AddNode(Node* node)
+{
+	_nodes.push_back(node);
+	return (int)_nodes.size() - 1;
+}
+
+NodeConnection* GraphBuilder::AddConnection(int fromNode, int fromSlot, int toNode, int toSlot)
+{
+	if (fromNode < 0 || (size_t)fromNode >= _nodes.size() || toNode < 0 || (size_t)toNode >= _nodes.size() || fromNode == toNode)
+		return nullptr;
+
+	auto& fromSlots = _nodes[fromNode]->GetSlots();
+	auto& toSlots = _nodes[toNode]->GetSlots();
+
+	if (fromSlot < 0 || (size_t)fromSlot >= fromSlots.size() || toSlot < 0 || (size_t)toSlot >= toSlots.size())
+		return nullptr;
+
+	auto from = fromSlots[fromSlot];
+	auto to = toSlots[toSlot];
+
+	if (!from->IsOutput() || !to->IsInput())
+		return nullptr;
+
+	auto connection = new NodeConnection(from, to);
+	_connections.push_back(connection);
+	return connection;
+}
+
+_Command* GraphBuilder::Commit(const char* label)
+{
+	if (_nodes.empty() && _connections.empty())
+		return nullptr;
+
+	auto command = new CreateNodesCommand(std::move(_nodes), std::move(_connections), _graph, label);
+
+	_nodes.clear();
+	_connections.clear();
+
+	return command;
+}
+
+void GraphBuilder::Clear()
+{
+	for (auto connection : _connections)
+		delete connection;
+	_connections.clear();
+
+	for (auto node : _nodes)
+		delete node;
+	_nodes.clear();
+}
\ No newline at end of file
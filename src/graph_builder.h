@@ -0,0 +1,48 @@
+#pragma once
+
+// std
+#include <string>
+#include <vector>
+
+// local
+#include "nodes_graph.h"
+
+// Builds many nodes and connections at once, e.g. for importers. Nothing
+// touches the graph until Commit, which hands everything over to a single
+// undoable command that inserts it in one pass. Since the graph isn't read,
+// a builder can be filled on another thread and the command Posted.
+class GraphBuilder {
+public:
+	GraphBuilder(NodesGraph* graph);
+	~GraphBuilder();
+
+	GraphBuilder(const GraphBuilder&) = delete;
+	GraphBuilder& operator=(const GraphBuilder&) = delete;
+
+	void Reserve(size_t nodeCount, size_t connectionCount);
+
+	// Return the index of the new node, or -1 if the type isn't registered.
+	int AddNode(const std::string& type, const ImVec2& position);
+	int AddNode(int typeId, const ImVec2& position);
+	// Takes ownership of an initialized node.
+	int AddNode(Node* node);
+
+	// Connects slots of two added nodes by index. Returns nullptr if an index is
+	// out of range or the slots can't be connected in that direction.
+	NodeConnection* AddConnection(int fromNode, int fromSlot, int toNode, int toSlot);
+
+	inline Node* GetNode(int index) const { return _nodes[index]; }
+	inline size_t GetNodeCount() const { return _nodes.size(); }
+	inline size_t GetConnectionCount() const { return _connections.size(); }
+
+	// The builder is empty afterwards. Returns nullptr if nothing was added.
+	_Command* Commit(const char* label = "Build Graph");
+	// Deletes everything added since the last Commit.
+	void Clear();
+
+private:
+	NodesGraph* _graph;
+
+	std::vector<Node*> _nodes;
+	std::vector<NodeConnection*> _connections;
+};
\ No newline at end of file
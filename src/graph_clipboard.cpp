@@ -0,0 +1,158 @@
+#include "graph_clipboard.h"
+
+// std
+#include <cstring>
+#include <unordered_map>
+
+// local
+#include "guid.h"
+#include "nodes_graph_settings.h"
+
+static void AppendRecords(const std::vector<std::string>& ids, const std::function<const std::string* (const std::string&)>& find, std::string& data)
+{
+	bool isFirst = true;
+	for (const auto& id : ids)
+	{
+		auto encoded = find(id);
+		if (encoded == nullptr)
+			continue;
+
+		if (!isFirst) data += ",\n";
+		data += *encoded;
+		isFirst = false;
+	}
+}
+
+std::string GraphClipboard::Encode(const GraphSnapshot& snapshot, const std::vector<std::string>& nodeIds,
+	const std::vector<std::string>& connectionIds, ImVec2 origin)
+{
+	auto dpiScale = NodesGraphSettings::GetDpiScale();
+
+	std::string data;
+	data += "{\"format\":\"";
+	data += Format;
+	data += "\",\"version\":" + std::to_string(Version);
+	data += ",\"x\":" + nlohmann::json(origin.x / dpiScale).dump();
+	data += ",\"y\":" + nlohmann::json(origin.y / dpiScale).dump();
+
+	data += ",\"nodes\":[\n";
+	AppendRecords(nodeIds, [&](const std::string& id) { return snapshot.FindEncodedNode(id); }, data);
+	data += "\n],\"connections\":[\n";
+	AppendRecords(connectionIds, [&](const std::string& id) { return snapshot.FindEncodedConnection(id); }, data);
+	data += "\n]}";
+
+	return data;
+}
+
+bool GraphClipboard::IsSubgraph(const char* text)
+{
+	static const std::string prefix = std::string("{\"format\":\"") + Format + "\"";
+	return text != nullptr && std::strncmp(text, prefix.c_str(), prefix.size()) == 0;
+}
+
+bool GraphClipboard::Decode(const std::string& text, ImVec2 position, const CreateNode& createNode,
+	std::vector<Node*>& nodes, std::vector<NodeConnection*>& connections, bool renewIds)
+{
+	using json = nlohmann::json;
+
+	json jsonSubgraph = json::parse(text, nullptr, false);
+	if (jsonSubgraph.is_discarded() || !jsonSubgraph.is_object() || jsonSubgraph.value("format", "") != Format)
+		return false;
+
+	std::vector<Node*> createdNodes;
+	std::vector<NodeConnection*> createdConnections;
+
+	try {
+		auto origin = ImVec2(jsonSubgraph.at("x").get<float>(), jsonSubgraph.at("y").get<float>());
+		auto offset = position / NodesGraphSettings::GetDpiScale() - origin;
+
+		json& jsonArrayNodes = jsonSubgraph.at("nodes");
+		json& jsonArrayConnections = jsonSubgraph.at("connections");
+
+		// Slot ids as written in the text, in the order the slots are visited (node, then its children).
+		std::vector<std::string> slotIds;
+		std::unordered_map<std::string, NodeSlot*> slots;
+
+		std::function<void(json&)> collectSlotIds = [&](json& jsonNode) {
+			if (renewIds)
+				jsonNode["id"] = Guid::CreateGuid();
+
+			for (auto& jsonSlot : jsonNode.at("slots")) {
+				slotIds.push_back(jsonSlot.at("id").get<std::string>());
+				if (renewIds)
+					jsonSlot["id"] = Guid::CreateGuid();
+			}
+
+			if (jsonNode.contains("nodes")) {
+				for (auto& jsonChild : jsonNode["nodes"])
+					collectSlotIds(jsonChild);
+			}
+		};
+
+		size_t slotIndex = 0;
+		std::function<void(const json&, Node*)> mapSlots = [&](const json& jsonNode, Node* node) {
+			auto& nodeSlots = node->GetSlots();
+			for (size_t i = 0; i < jsonNode["slots"].size(); i++, slotIndex++) {
+				if (i < nodeSlots.size())
+					slots[slotIds[slotIndex]] = nodeSlots[i];
+			}
+
+			auto groupNode = node->AsGroup();
+			if (groupNode != nullptr && jsonNode.contains("nodes")) {
+				auto& children = groupNode->GetNodes();
+				auto& jsonChildren = jsonNode["nodes"];
+				for (size_t i = 0; i < jsonChildren.size() && i < children.size(); i++)
+					mapSlots(jsonChildren[i], children[i]);
+			}
+		};
+
+		createdNodes.reserve(jsonArrayNodes.size());
+		slots.reserve(jsonArrayNodes.size() * 2);
+
+		for (auto& jsonNode : jsonArrayNodes)
+		{
+			auto node = createNode(jsonNode.at("type").get<std::string>());
+			if (node == nullptr)
+				throw std::runtime_error("Unknown/Unregistered node type");
+
+			createdNodes.push_back(node);
+
+			slotIds.clear();
+			slotIndex = 0;
+			collectSlotIds(jsonNode);
+
+			jsonNode["x"] = jsonNode.at("x").get<float>() + offset.x;
+			jsonNode["y"] = jsonNode.at("y").get<float>() + offset.y;
+
+			node->FromJson(jsonNode);
+			mapSlots(jsonNode, node);
+		}
+
+		createdConnections.reserve(jsonArrayConnections.size());
+		for (auto& jsonConnection : jsonArrayConnections)
+		{
+			auto from = slots.find(jsonConnection.at("from").get<std::string>());
+			auto to = slots.find(jsonConnection.at("to").get<std::string>());
+			if (from == slots.end() || to == slots.end())
+				continue;
+
+			auto connection = new NodeConnection(from->second, to->second);
+			createdConnections.push_back(connection);
+
+			if (renewIds)
+				jsonConnection["id"] = connection->GetId();
+			connection->FromJson(jsonConnection);
+		}
+	}
+	catch (const std::exception& e) {
+		for (auto connection : createdConnections)
+			delete connection;
+		for (auto node : createdNodes)
+			delete node;
+		return false;
+	}
+
+	nodes.insert(nodes.end(), createdNodes.begin(), createdNodes.end());
+	connections.insert(connections.end(), createdConnections.begin(), createdConnections.end());
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+// std
+#include <functional>
+#include <string>
+#include <vector>
+
+// local
+#include "node.h"
+#include "node_connection.h"
+#include "graph_snapshot.h"
+
+// Text format of copied nodes (group children included) and the connections
+// between them. It goes through the system clipboard, so it can be pasted into
+// any open graph, also in another process:
+//
+//   {"format":"nodes_graph.subgraph","version":1,"x":..,"y":..,
+//    "nodes":[...],"connections":[...]}
+//
+// Nodes and connections are stored as saved in a .sgraph file, `x`/`y` is the
+// point that ends up under the cursor when pasting.
+class GraphClipboard {
+public:
+	using CreateNode = std::function<Node* (const std::string& type)>;
+
+	// Joins the already encoded records of the snapshot, nothing is cloned or re-encoded.
+	static std::string Encode(const GraphSnapshot& snapshot, const std::vector<std::string>& nodeIds,
+		const std::vector<std::string>& connectionIds, ImVec2 origin);
+
+	// Cheap check, for enabling "Paste" without parsing the clipboard every frame.
+	static bool IsSubgraph(const char* text);
+
+	// Creates the nodes and connections with fresh ids, so the same text can be
+	// pasted any number of times. Fails without creating anything if the text
+	// isn't a subgraph or uses an unregistered node type. `renewIds` can only be
+	// turned off for nodes that are never added to a graph (e.g. templates).
+	static bool Decode(const std::string& text, ImVec2 position, const CreateNode& createNode,
+		std::vector<Node*>& nodes, std::vector<NodeConnection*>& connections, bool renewIds = true);
+
+	inline static constexpr const char* Format = "nodes_graph.subgraph";
+	inline static constexpr int Version = 1;
+};
\ No newline at end of file
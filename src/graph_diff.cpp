@@ -0,0 +1,360 @@
+#include "graph_diff.h"
+
+// std
+#include <algorithm>
+#include <unordered_set>
+
+using json = nlohmann::json;
+
+static bool ParseRecords(json& jsonRecords, GraphDocument::Records& records)
+{
+	if (!jsonRecords.is_array())
+		return false;
+
+	records.reserve(jsonRecords.size());
+	for (auto& record : jsonRecords)
+	{
+		if (!record.is_object() || !record.contains("id") || !record["id"].is_string())
+			return false;
+
+		auto id = record["id"].get<std::string>();
+		records.emplace(std::move(id), std::move(record));
+	}
+
+	return true;
+}
+
+static void AppendRecords(const GraphDocument::Records& records, std::string& data)
+{
+	std::vector<const std::string*> ids;
+	ids.reserve(records.size());
+	for (const auto& [id, _] : records)
+		ids.push_back(&id);
+
+	std::sort(ids.begin(), ids.end(), [](const std::string* a, const std::string* b) { return *a < *b; });
+
+	bool isFirst = true;
+	for (auto id : ids)
+	{
+		if (!isFirst) data += ",\n";
+		data += records.at(*id).dump();
+		isFirst = false;
+	}
+}
+
+// Both objects, their keys are sorted so they can be walked together.
+static void GetChangedFields(const json& a, const json& b, std::vector<std::string>& fields)
+{
+	auto itA = a.items().begin();
+	auto itB = b.items().begin();
+	auto endA = a.items().end();
+	auto endB = b.items().end();
+
+	while (itA != endA || itB != endB)
+	{
+		if (itB == endB || (itA != endA && itA.key() < itB.key())) {
+			fields.push_back(itA.key());
+			++itA;
+		}
+		else if (itA == endA || itB.key() < itA.key()) {
+			fields.push_back(itB.key());
+			++itB;
+		}
+		else {
+			if (itA.value() != itB.value())
+				fields.push_back(itA.key());
+			++itA;
+			++itB;
+		}
+	}
+}
+
+static void CompareRecords(const GraphDocument::Records& base, const GraphDocument::Records& other, bool isNode, std::vector<GraphChange>& changes)
+{
+	auto first = changes.size();
+
+	for (const auto& [id, record] : other)
+	{
+		auto it = base.find(id);
+		if (it == base.end()) {
+			changes.push_back({ GraphChange::Added, isNode, id });
+			continue;
+		}
+
+		if (it->second == record)
+			continue;
+
+		GraphChange change{ GraphChange::Edited, isNode, id };
+		GetChangedFields(it->second, record, change.fields);
+
+		auto isMoved = isNode && std::all_of(change.fields.begin(), change.fields.end(), [](const std::string& field) {
+			return field == "x" || field == "y";
+			});
+
+		if (isMoved)
+			change.kind = GraphChange::Moved;
+
+		changes.push_back(std::move(change));
+	}
+
+	for (const auto& [id, _] : base)
+	{
+		if (!other.contains(id))
+			changes.push_back({ GraphChange::Removed, isNode, id });
+	}
+
+	std::sort(changes.begin() + first, changes.end(), [](const GraphChange& a, const GraphChange& b) {
+		return a.id < b.id;
+		});
+}
+
+// The record of one side, or nullptr where it doesn't have one.
+static const json* FindRecord(const GraphDocument::Records& records, const std::string& id)
+{
+	auto it = records.find(id);
+	return it != records.end() ? &it->second : nullptr;
+}
+
+static bool AreEqual(const json* a, const json* b)
+{
+	return a == nullptr || b == nullptr ? a == b : *a == *b;
+}
+
+static json MergeFields(const json& base, const json& ours, const json& theirs, bool isNode, const std::string& id, std::vector<GraphConflict>& conflicts)
+{
+	std::vector<std::string> fields;
+	GetChangedFields(base, ours, fields);
+	GetChangedFields(base, theirs, fields);
+
+	std::sort(fields.begin(), fields.end());
+	fields.erase(std::unique(fields.begin(), fields.end()), fields.end());
+
+	auto merged = base;
+	for (const auto& field : fields)
+	{
+		auto baseValue = base.contains(field) ? &base[field] : nullptr;
+		auto ourValue = ours.contains(field) ? &ours[field] : nullptr;
+		auto theirValue = theirs.contains(field) ? &theirs[field] : nullptr;
+
+		auto value = ourValue;
+		if (AreEqual(ourValue, baseValue))
+			value = theirValue;
+		else if (!AreEqual(theirValue, baseValue) && !AreEqual(ourValue, theirValue))
+			conflicts.push_back({ GraphConflict::EditedOnBothSides, isNode, id, field });
+
+		if (value != nullptr)
+			merged[field] = *value;
+		else
+			merged.erase(field);
+	}
+
+	return merged;
+}
+
+static void MergeRecords(const GraphDocument::Records& base, GraphDocument::Records& ours, const GraphDocument::Records& theirs,
+	bool isNode, std::vector<GraphConflict>& conflicts)
+{
+	for (const auto& [id, theirRecord] : theirs)
+	{
+		auto baseRecord = FindRecord(base, id);
+		auto ourRecord = ours.find(id);
+
+		if (ourRecord == ours.end())
+		{
+			// Added by them, or removed by us, unless they changed it.
+			if (baseRecord == nullptr || *baseRecord != theirRecord)
+				ours.emplace(id, theirRecord);
+
+			if (baseRecord != nullptr && *baseRecord != theirRecord)
+				conflicts.push_back({ GraphConflict::EditedAndRemoved, isNode, id });
+
+			continue;
+		}
+
+		if (ourRecord->second == theirRecord || (baseRecord != nullptr && *baseRecord == theirRecord))
+			continue;
+
+		if (baseRecord == nullptr)
+			conflicts.push_back({ GraphConflict::AddedOnBothSides, isNode, id });
+		else if (*baseRecord == ourRecord->second)
+			ourRecord->second = theirRecord;
+		else
+			ourRecord->second = MergeFields(*baseRecord, ourRecord->second, theirRecord, isNode, id, conflicts);
+	}
+
+	for (const auto& [id, baseRecord] : base)
+	{
+		if (theirs.contains(id))
+			continue;
+
+		// Removed by them, unless we changed it.
+		auto ourRecord = ours.find(id);
+		if (ourRecord == ours.end())
+			continue;
+
+		if (ourRecord->second == baseRecord)
+			ours.erase(ourRecord);
+		else
+			conflicts.push_back({ GraphConflict::EditedAndRemoved, isNode, id });
+	}
+}
+
+static void CollectSlots(const json& node, std::unordered_set<std::string>& slots)
+{
+	if (node.contains("slots") && node["slots"].is_array())
+	{
+		for (const auto& slot : node["slots"])
+		{
+			if (slot.is_object() && slot.contains("id") && slot["id"].is_string())
+				slots.insert(slot["id"].get<std::string>());
+		}
+	}
+
+	// Group children.
+	if (node.contains("nodes") && node["nodes"].is_array())
+	{
+		for (const auto& child : node["nodes"])
+			CollectSlots(child, slots);
+	}
+}
+
+bool GraphDocument::Parse(const std::string& data)
+{
+	id.clear();
+	nodes.clear();
+	connections.clear();
+	view = json::object();
+
+	if (data.empty())
+		return true;
+
+	auto jsonGraph = json::parse(data, nullptr, false);
+	if (jsonGraph.is_discarded() || !jsonGraph.is_object())
+		return false;
+
+	if (jsonGraph.contains("header") && jsonGraph["header"].is_object())
+		id = jsonGraph["header"].value("id", "");
+
+	if (!ParseRecords(jsonGraph["nodes"], nodes) || !ParseRecords(jsonGraph["connections"], connections))
+		return false;
+
+	for (auto field : { "scale", "offset_x", "offset_y" })
+	{
+		if (jsonGraph.contains(field))
+			view[field] = jsonGraph[field];
+	}
+
+	return true;
+}
+
+std::string GraphDocument::Serialize() const
+{
+	std::string data = "{";
+	if (!id.empty())
+	{
+		data += "\"header\":";
+		data += json({ { "id", id } }).dump();
+		data += ",\n";
+	}
+
+	data += "\"nodes\":[\n";
+	AppendRecords(nodes, data);
+	data += "\n],\"connections\":[\n";
+	AppendRecords(connections, data);
+	data += "\n],\"scale\":";
+	data += view.value("scale", json(0)).dump();
+	data += ",\"offset_x\":";
+	data += view.value("offset_x", json(0)).dump();
+	data += ",\"offset_y\":";
+	data += view.value("offset_y", json(0)).dump();
+	data += "}";
+
+	return data;
+}
+
+void GraphDiff::Compare(const GraphDocument& base, const GraphDocument& other, std::vector<GraphChange>& changes)
+{
+	CompareRecords(base.nodes, other.nodes, true, changes);
+	CompareRecords(base.connections, other.connections, false, changes);
+}
+
+bool GraphDiff::Merge(const GraphDocument& base, GraphDocument& ours, const GraphDocument& theirs, std::vector<GraphConflict>& conflicts)
+{
+	auto firstConflict = conflicts.size();
+
+	if (ours.id.empty())
+		ours.id = theirs.id;
+
+	MergeRecords(base.nodes, ours.nodes, theirs.nodes, true, conflicts);
+	MergeRecords(base.connections, ours.connections, theirs.connections, false, conflicts);
+
+	// e.g. one side connected a slot of a node the other side removed.
+	std::unordered_set<std::string> slots;
+	for (const auto& [_, node] : ours.nodes)
+		CollectSlots(node, slots);
+
+	for (auto it = ours.connections.begin(); it != ours.connections.end(); )
+	{
+		const auto& connection = it->second;
+		if (slots.contains(connection.value("from", "")) && slots.contains(connection.value("to", ""))) {
+			++it;
+			continue;
+		}
+
+		conflicts.push_back({ GraphConflict::MissingSlot, false, it->first });
+		it = ours.connections.erase(it);
+	}
+
+	std::sort(conflicts.begin() + firstConflict, conflicts.end(), [](const GraphConflict& a, const GraphConflict& b) {
+		return a.isNode != b.isNode ? a.isNode : a.id < b.id;
+		});
+
+	return conflicts.size() == firstConflict;
+}
+
+std::string GraphDiff::Describe(const GraphChange& change)
+{
+	std::string text;
+	switch (change.kind)
+	{
+	case GraphChange::Added: text = "+ "; break;
+	case GraphChange::Removed: text = "- "; break;
+	case GraphChange::Moved: text = "~ "; break;
+	case GraphChange::Edited: text = "* "; break;
+	}
+
+	text += change.isNode ? "node " : "connection ";
+	text += change.id;
+
+	if (change.kind == GraphChange::Moved)
+		text += " moved";
+
+	if (change.kind == GraphChange::Edited)
+	{
+		text += " edited: ";
+		for (size_t i = 0; i < change.fields.size(); i++)
+		{
+			if (i > 0) text += ", ";
+			text += change.fields[i];
+		}
+	}
+
+	return text;
+}
+
+std::string GraphDiff::Describe(const GraphConflict& conflict)
+{
+	std::string text = "! ";
+	text += conflict.isNode ? "node " : "connection ";
+	text += conflict.id;
+
+	switch (conflict.kind)
+	{
+	case GraphConflict::EditedOnBothSides: text += " edited on both sides: " + conflict.field; break;
+	case GraphConflict::AddedOnBothSides: text += " added on both sides"; break;
+	case GraphConflict::EditedAndRemoved: text += " edited on one side, removed on the other"; break;
+	case GraphConflict::MissingSlot: text += " removed, one of its slots no longer exists"; break;
+	}
+
+	return text;
+}
\ No newline at end of file
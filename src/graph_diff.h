@@ -0,0 +1,82 @@
+#pragma once
+
+// std
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// external
+#include "json.h"
+
+// A .sgraph file as its node and connection records by id, so files can be
+// compared and merged without creating their nodes (node types don't need to
+// be registered).
+struct GraphDocument {
+	using Records = std::unordered_map<std::string, nlohmann::json>;
+
+	std::string id;
+	Records nodes;
+	Records connections;
+	// scale, offset_x, offset_y
+	nlohmann::json view = nlohmann::json::object();
+
+	// Fails if the data isn't a graph, an empty string is an empty graph.
+	bool Parse(const std::string& data);
+	// One record per line in id order, as NodesGraph::Serialize writes them.
+	// The header only has the id, loading the document into a NodesGraph and
+	// saving it writes the full header.
+	std::string Serialize() const;
+};
+
+// Change of a node or connection from one document to another. Records are
+// matched by id, a node whose only changed fields are `x`/`y` is Moved.
+struct GraphChange {
+	enum Kind {
+		Added,
+		Removed,
+		Moved,
+		Edited
+	};
+
+	Kind kind;
+	bool isNode;
+	std::string id;
+	// Top level fields of the record that changed (Moved/Edited). Group children
+	// are a single field ("nodes"), as are the slots.
+	std::vector<std::string> fields;
+};
+
+// Change made by both sides of a merge that couldn't be resolved. The merged
+// document then keeps our side: our value of the field, or the record that
+// wasn't removed. Connections left without one of their slots are removed.
+struct GraphConflict {
+	enum Kind {
+		EditedOnBothSides,
+		AddedOnBothSides,
+		EditedAndRemoved,
+		MissingSlot
+	};
+
+	Kind kind;
+	bool isNode;
+	std::string id;
+	// Of EditedOnBothSides.
+	std::string field;
+};
+
+class GraphDiff {
+public:
+	// O(records + changed fields): what changed from `base` to `other`, nodes
+	// first, each sorted by id.
+	static void Compare(const GraphDocument& base, const GraphDocument& other, std::vector<GraphChange>& changes);
+
+	// Three-way merge, applies the changes `theirs` made to `base` onto `ours`.
+	// Records changed by both sides are merged field by field, the same change
+	// made by both is no conflict. Returns false if there were conflicts, `ours`
+	// is completely merged either way. Only changed records are copied.
+	static bool Merge(const GraphDocument& base, GraphDocument& ours, const GraphDocument& theirs, std::vector<GraphConflict>& conflicts);
+
+	// One line, e.g. "~ node <id> moved" or "* node <id> edited: label, slots".
+	static std::string Describe(const GraphChange& change);
+	static std::string Describe(const GraphConflict& conflict);
+};
\ No newline at end of file
@@ -0,0 +1,523 @@
+#include "graph_project.h"
+
+// std
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+// external
+#include <json.h>
+
+// local
+#include "nodes_graph.h"
+
+using json = nlohmann::json;
+
+static bool CompareNames(const GraphFileInfo& info, const std::string& name)
+{
+	return info.name < name;
+}
+
+static void ReadKeys(const json& jsonKeys, std::vector<NodeKey>& keys)
+{
+	keys.clear();
+	for (const auto& key : jsonKeys)
+	{
+		if (key.is_array() && key.size() == 3)
+			keys.push_back({ key[0].get<std::string>(), key[1].get<std::string>(), key[2].get<int>() == 0 ? NodeKey::Definition : NodeKey::Reference });
+	}
+}
+
+static void ReadHeader(const json& header, GraphFileInfo& info)
+{
+	info.id = header.value("id", "");
+	info.nodeCount = header.value("node_count", (size_t)0);
+	info.connectionCount = header.value("connection_count", (size_t)0);
+	info.hash = header.value("hash", "");
+	info.invalidCount = header.value("invalid_count", (size_t)0);
+	ReadKeys(header.value("keys", json::array()), info.keys);
+}
+
+// An entry of the index file, an array as objects take far longer to parse:
+// [name, size, modified time, has header, id, nodes, connections, hash, invalid nodes, keys]
+static bool ReadIndexEntry(const json& entry, GraphFileInfo& info)
+{
+	if (!entry.is_array() || entry.size() != 10)
+		return false;
+
+	entry[0].get_to(info.name);
+	entry[1].get_to(info.size);
+	entry[2].get_to(info.modifiedTime);
+	entry[3].get_to(info.hasHeader);
+	entry[4].get_to(info.id);
+	entry[5].get_to(info.nodeCount);
+	entry[6].get_to(info.connectionCount);
+	entry[7].get_to(info.hash);
+	entry[8].get_to(info.invalidCount);
+	ReadKeys(entry[9], info.keys);
+	return true;
+}
+
+static json WriteIndexEntry(const GraphFileInfo& info)
+{
+	json jsonKeys = json::array();
+	for (const auto& key : info.keys)
+		jsonKeys.push_back({ key.name, key.value, key.role == NodeKey::Definition ? 0 : 1 });
+
+	return json::array({ info.name, info.size, info.modifiedTime, info.hasHeader, info.id, info.nodeCount, info.connectionCount, info.hash, info.invalidCount, jsonKeys });
+}
+
+GraphProject::~GraphProject()
+{
+	if (_isIndexChanged)
+		SaveIndex();
+}
+
+void GraphProject::Open(const std::string& directory)
+{
+	Close();
+	if (directory.empty())
+		return;
+
+	_directory = directory;
+
+	// Started first, changes made while scanning are picked up by the next Poll.
+	_watcher.Start(directory);
+
+	LoadIndex();
+	Scan();
+	IndexKeys();
+	_version++;
+
+	if (_isIndexChanged)
+		SaveIndex();
+}
+
+void GraphProject::Close()
+{
+	if (_isIndexChanged)
+		SaveIndex();
+
+	_watcher.Stop();
+	_directory.clear();
+	_files.clear();
+	_keys.clear();
+	_isChanged = false;
+	_version++;
+}
+
+bool GraphProject::Poll()
+{
+	if (_directory.empty())
+		return false;
+
+	std::vector<std::string> names;
+	if (_watcher.Poll(names))
+	{
+		std::sort(names.begin(), names.end());
+		names.erase(std::unique(names.begin(), names.end()), names.end());
+
+		for (const auto& name : names)
+		{
+			std::filesystem::path path(name);
+			if (path.extension() == ".sgraph")
+				RefreshFileIfModified(path.stem().string());
+		}
+	}
+	else if (_watcher.IsWatching() || std::chrono::steady_clock::now() - _scanTime >= RescanInterval)
+	{
+		// Events were missed, or nothing is watched.
+		if (Scan()) {
+			IndexKeys();
+			_isChanged = true;
+		}
+	}
+
+	if (_isIndexChanged)
+		SaveIndex();
+
+	return CommitChanges();
+}
+
+void GraphProject::Refresh(const std::string& name)
+{
+	RefreshFile(name);
+	CommitChanges();
+}
+
+void GraphProject::RefreshIfModified(const std::string& name)
+{
+	RefreshFileIfModified(name);
+	CommitChanges();
+}
+
+void GraphProject::Update(const std::string& name, NodesGraph& graph)
+{
+	auto existing = Find(name);
+
+	GraphFileInfo info;
+	info.name = name;
+	if (existing != nullptr) {
+		info.hasHeader = existing->hasHeader;
+		info.size = existing->size;
+		info.modifiedTime = existing->modifiedTime;
+	}
+	ReadInfo(graph, info);
+
+	Insert(std::move(info));
+	CommitChanges();
+}
+
+void GraphProject::Remove(const std::string& name)
+{
+	RemoveFile(name);
+	CommitChanges();
+}
+
+void GraphProject::RefreshFile(const std::string& name)
+{
+	GraphFileInfo info;
+	info.name = name;
+	if (!ReadInfo(GetPath(name), info)) {
+		RemoveFile(name);
+		return;
+	}
+
+	Insert(std::move(info));
+}
+
+void GraphProject::RefreshFileIfModified(const std::string& name)
+{
+	uintmax_t size;
+	int64_t modifiedTime;
+	if (!ReadFileTime(GetPath(name), size, modifiedTime)) {
+		RemoveFile(name);
+		return;
+	}
+
+	auto info = Find(name);
+	if (info == nullptr || info->size != size || info->modifiedTime != modifiedTime)
+		RefreshFile(name);
+}
+
+void GraphProject::RemoveFile(const std::string& name)
+{
+	auto it = std::lower_bound(_files.begin(), _files.end(), name, CompareNames);
+	if (it == _files.end() || it->name != name)
+		return;
+
+	RemoveKeys(*it);
+	_files.erase(it);
+	_isIndexChanged = true;
+	_isChanged = true;
+}
+
+void GraphProject::Insert(GraphFileInfo&& info)
+{
+	auto it = std::lower_bound(_files.begin(), _files.end(), info.name, CompareNames);
+	if (it != _files.end() && it->name == info.name) {
+		RemoveKeys(*it);
+		*it = std::move(info);
+	}
+	else
+		it = _files.insert(it, std::move(info));
+
+	AddKeys(*it);
+	_isIndexChanged = true;
+	_isChanged = true;
+}
+
+bool GraphProject::CommitChanges()
+{
+	if (!_isChanged)
+		return false;
+
+	_isChanged = false;
+	_version++;
+	return true;
+}
+
+std::string GraphProject::GetPath(const std::string& name) const
+{
+	return _directory + "/" + name + ".sgraph";
+}
+
+const GraphFileInfo* GraphProject::Find(const std::string& name) const
+{
+	auto it = std::lower_bound(_files.begin(), _files.end(), name, CompareNames);
+	return it != _files.end() && it->name == name ? &*it : nullptr;
+}
+
+const std::vector<std::string>& GraphProject::GetDefinitions(const std::string& name, const std::string& value) const
+{
+	auto it = _keys.find(MakeKey(name, value));
+	return it != _keys.end() ? it->second.definitions : _empty;
+}
+
+const std::vector<std::string>& GraphProject::GetReferences(const std::string& name, const std::string& value) const
+{
+	auto it = _keys.find(MakeKey(name, value));
+	return it != _keys.end() ? it->second.references : _empty;
+}
+
+std::vector<std::string> GraphProject::FindIdentical(const std::string& name) const
+{
+	std::vector<std::string> names;
+
+	auto info = Find(name);
+	if (info == nullptr || info->hash.empty())
+		return names;
+
+	for (const auto& other : _files)
+	{
+		if (other.hash == info->hash && other.name != name)
+			names.push_back(other.name);
+	}
+
+	return names;
+}
+
+bool GraphProject::HaveSameContent(const std::string& name, const std::string& otherName) const
+{
+	auto info = Find(name);
+	auto otherInfo = Find(otherName);
+	return info != nullptr && otherInfo != nullptr && !info->hash.empty() && info->hash == otherInfo->hash;
+}
+
+bool GraphProject::IsDefinedElsewhere(const std::string& name, const std::string& value, const std::string& graphId) const
+{
+	for (const auto& fileName : GetDefinitions(name, value))
+	{
+		auto info = Find(fileName);
+		if (info != nullptr && info->id != graphId)
+			return true;
+	}
+
+	return false;
+}
+
+bool GraphProject::ReadInfo(const std::string& path, GraphFileInfo& info)
+{
+	if (!ReadFileTime(path, info.size, info.modifiedTime))
+		return false;
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	std::string line;
+	std::getline(file, line);
+	if (!line.empty() && line.back() == '\r')
+		line.pop_back();
+
+	// {"header":{...},
+	static const std::string prefix = "{\"header\":";
+	if (line.size() > prefix.size() + 1 && line.compare(0, prefix.size(), prefix) == 0 && line.back() == ',')
+	{
+		json header = json::parse(line.begin() + prefix.size(), line.end() - 1, nullptr, false);
+		// Without the counts (e.g. written by GraphDocument) it is read like an older file.
+		if (!header.is_discarded() && header.is_object() && header.contains("node_count"))
+		{
+			ReadHeader(header, info);
+			info.hasHeader = true;
+			return true;
+		}
+	}
+
+	// Written before headers, or a new empty file.
+	file.clear();
+	file.seekg(0);
+	std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+	info.hasHeader = false;
+	info.keys.clear();
+	// The id is made up on every load, see GraphProject::Update.
+	if (data.empty())
+		return true;
+
+	NodesGraph graph;
+	graph.Deserialize(data);
+	ReadInfo(graph, info);
+	return true;
+}
+
+void GraphProject::ReadInfo(NodesGraph& graph, GraphFileInfo& info)
+{
+	auto snapshot = graph.TakeSnapshot();
+	ReadHeader(json::parse(snapshot.GetHeader()), info);
+}
+
+bool GraphProject::ReadFileTime(const std::string& path, uintmax_t& size, int64_t& modifiedTime)
+{
+	std::error_code error;
+	size = std::filesystem::file_size(path, error);
+	if (error)
+		return false;
+
+	auto time = std::filesystem::last_write_time(path, error);
+	if (error)
+		return false;
+
+	modifiedTime = (int64_t)time.time_since_epoch().count();
+	return true;
+}
+
+bool GraphProject::Scan()
+{
+	_scanTime = std::chrono::steady_clock::now();
+
+	struct Entry {
+		std::string name;
+		std::string path;
+		uintmax_t size;
+		int64_t modifiedTime;
+	};
+
+	std::vector<Entry> entries;
+	entries.reserve(_files.size());
+
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(_directory, error))
+	{
+		if (!entry.is_regular_file(error) || entry.path().extension() != ".sgraph")
+			continue;
+
+		auto size = entry.file_size(error);
+		if (error) continue;
+		auto modifiedTime = entry.last_write_time(error);
+		if (error) continue;
+
+		entries.push_back({ entry.path().stem().string(), entry.path().string(), size, (int64_t)modifiedTime.time_since_epoch().count() });
+	}
+
+	std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+		return a.name < b.name;
+		});
+
+	// Both sorted by name, infos of files that didn't change are moved over.
+	std::vector<GraphFileInfo> files;
+	files.reserve(entries.size());
+	bool isChanged = entries.size() != _files.size();
+
+	auto cached = _files.begin();
+	for (const auto& entry : entries)
+	{
+		while (cached != _files.end() && cached->name < entry.name)
+			cached++;
+
+		if (cached != _files.end() && cached->name == entry.name &&
+			cached->size == entry.size && cached->modifiedTime == entry.modifiedTime)
+		{
+			files.push_back(std::move(*cached++));
+			continue;
+		}
+
+		GraphFileInfo info;
+		info.name = entry.name;
+		if (ReadInfo(entry.path, info))
+			files.push_back(std::move(info));
+
+		isChanged = true;
+	}
+
+	_files = std::move(files);
+
+	_isIndexChanged |= isChanged;
+	return isChanged;
+}
+
+void GraphProject::IndexKeys()
+{
+	_keys.clear();
+
+	for (const auto& info : _files)
+		AddKeys(info);
+}
+
+void GraphProject::AddKeys(const GraphFileInfo& info)
+{
+	for (const auto& key : info.keys)
+	{
+		// Kept sorted, like the files.
+		auto& keyFiles = _keys[MakeKey(key.name, key.value)];
+		auto& names = key.role == NodeKey::Definition ? keyFiles.definitions : keyFiles.references;
+		names.insert(std::upper_bound(names.begin(), names.end(), info.name), info.name);
+	}
+}
+
+void GraphProject::RemoveKeys(const GraphFileInfo& info)
+{
+	for (const auto& key : info.keys)
+	{
+		auto it = _keys.find(MakeKey(key.name, key.value));
+		if (it == _keys.end())
+			continue;
+
+		auto& names = key.role == NodeKey::Definition ? it->second.definitions : it->second.references;
+		auto name = std::lower_bound(names.begin(), names.end(), info.name);
+		if (name != names.end() && *name == info.name)
+			names.erase(name);
+
+		if (it->second.definitions.empty() && it->second.references.empty())
+			_keys.erase(it);
+	}
+}
+
+void GraphProject::LoadIndex()
+{
+	std::ifstream file(_directory + "/" + IndexFileName, std::ios::binary);
+	if (!file)
+		return;
+
+	json index = json::parse(file, nullptr, false);
+	if (index.is_discarded() || !index.is_object() || index.value("version", 0) != IndexVersion || !index.contains("files"))
+		return;
+
+	// A damaged entry is dropped, the file is read again by the scan.
+	for (const auto& entry : index["files"])
+	{
+		GraphFileInfo info;
+		try
+		{
+			if (ReadIndexEntry(entry, info) && !info.name.empty())
+				_files.push_back(std::move(info));
+		}
+		catch (const json::exception&)
+		{
+		}
+	}
+
+	std::sort(_files.begin(), _files.end(), [](const GraphFileInfo& a, const GraphFileInfo& b) {
+		return a.name < b.name;
+		});
+}
+
+void GraphProject::SaveIndex()
+{
+	_isIndexChanged = false;
+	if (_directory.empty())
+		return;
+
+	json jsonFiles = json::array();
+	for (const auto& info : _files)
+		jsonFiles.push_back(WriteIndexEntry(info));
+
+	json index;
+	index["version"] = IndexVersion;
+	index["files"] = jsonFiles;
+
+	// Replaced in one step, a reader never sees half of it.
+	auto path = _directory + "/" + IndexFileName;
+	auto tempPath = path + ".tmp";
+	{
+		std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+		if (!file)
+			return;
+
+		file << index.dump();
+	}
+
+	std::error_code error;
+	std::filesystem::rename(tempPath, path, error);
+}
\ No newline at end of file
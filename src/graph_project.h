@@ -0,0 +1,131 @@
+#pragma once
+
+// std
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// local
+#include "directory_watcher.h"
+#include "node.h"
+
+class NodesGraph;
+
+// A graph file as described by its header.
+struct GraphFileInfo {
+	std::string name;
+	std::string id;
+	size_t nodeCount = 0;
+	size_t connectionCount = 0;
+	// Of the saved nodes and connections (see GraphSnapshot::GetContentHash), empty for an empty file.
+	std::string hash;
+	// Invalid nodes when the graph was saved.
+	size_t invalidCount = 0;
+	// Definitions are exported to other graphs, references are resolved in them.
+	std::vector<NodeKey> keys;
+	// Written before headers existed, the info was taken from the loaded graph.
+	bool hasHeader = true;
+
+	// Of the file the info was read from, a file with a different size or
+	// write time is read again.
+	uintmax_t size = 0;
+	int64_t modifiedTime = 0;
+};
+
+// The graphs of a directory, indexed by the header line at the top of every
+// file (see GraphSnapshot::GetHeader) so keys can be resolved across files
+// without loading them. Graphs are only opened when navigated to.
+//
+// The infos are cached in an index file in the directory (IndexFileName), on
+// Open only the files whose size or write time changed are read. Afterwards
+// the directory is watched and changed files are read again in Poll.
+class GraphProject {
+public:
+	inline static constexpr const char* IndexFileName = ".sgraph_index";
+	inline static constexpr int IndexVersion = 1;
+	// Without a watcher the directory is rescanned this often.
+	inline static constexpr std::chrono::seconds RescanInterval = std::chrono::seconds(2);
+
+	~GraphProject();
+
+	void Open(const std::string& directory);
+	void Close();
+	// Applies the changes made to the directory since the last call and writes
+	// the index file if needed. Returns whether any info changed.
+	bool Poll();
+
+	// Reads the header of a file again, e.g. after it was saved.
+	void Refresh(const std::string& name);
+	// Only if the file's size or write time changed.
+	void RefreshIfModified(const std::string& name);
+	// Takes the info from a loaded graph instead of its file.
+	void Update(const std::string& name, NodesGraph& graph);
+	void Remove(const std::string& name);
+
+	inline const std::string& GetDirectory() const { return _directory; }
+	std::string GetPath(const std::string& name) const;
+
+	// Sorted by name.
+	inline const std::vector<GraphFileInfo>& GetFiles() const { return _files; }
+	const GraphFileInfo* Find(const std::string& name) const;
+
+	// Names of the files defining/referencing the key.
+	const std::vector<std::string>& GetDefinitions(const std::string& name, const std::string& value) const;
+	const std::vector<std::string>& GetReferences(const std::string& name, const std::string& value) const;
+	// Files with the same nodes and connections as the file, by content hash.
+	std::vector<std::string> FindIdentical(const std::string& name) const;
+	// False if either file has no hash yet (saved before hashes, or empty).
+	bool HaveSameContent(const std::string& name, const std::string& otherName) const;
+
+	// Whether a graph other than `graphId` defines the key.
+	bool IsDefinedElsewhere(const std::string& name, const std::string& value, const std::string& graphId) const;
+
+	// Bumped whenever files are added, removed or refreshed.
+	inline uint64_t GetVersion() const { return _version; }
+
+	// Fails if the file can't be read. Files without a header are loaded to fill in the info.
+	static bool ReadInfo(const std::string& path, GraphFileInfo& info);
+	static void ReadInfo(NodesGraph& graph, GraphFileInfo& info);
+	// False if the file doesn't exist.
+	static bool ReadFileTime(const std::string& path, uintmax_t& size, int64_t& modifiedTime);
+
+private:
+	struct KeyFiles {
+		std::vector<std::string> definitions;
+		std::vector<std::string> references;
+	};
+
+	std::string _directory;
+	std::vector<GraphFileInfo> _files;
+	std::unordered_map<std::string, KeyFiles> _keys;
+	uint64_t _version = 0;
+	// Files were added, removed or read again since the version was bumped.
+	bool _isChanged = false;
+
+	DirectoryWatcher _watcher;
+	std::chrono::steady_clock::time_point _scanTime;
+	bool _isIndexChanged = false;
+
+	inline static const std::vector<std::string> _empty;
+
+	inline static std::string MakeKey(const std::string& name, const std::string& value) { return name + '\x1f' + value; }
+
+	// Returns whether any file was added, removed or read again.
+	bool Scan();
+	// Refresh/RefreshIfModified/Remove, without bumping the version.
+	void RefreshFile(const std::string& name);
+	void RefreshFileIfModified(const std::string& name);
+	void RemoveFile(const std::string& name);
+	void Insert(GraphFileInfo&& info);
+	// Bumps the version once for all changes made since the last call.
+	bool CommitChanges();
+
+	void IndexKeys();
+	void AddKeys(const GraphFileInfo& info);
+	void RemoveKeys(const GraphFileInfo& info);
+
+	void LoadIndex();
+	void SaveIndex();
+};
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include "graph_reachability.h"
+
+void GraphReachability::Clear()
+{
+	_vertices.clear();
+	_edges.clear();
+
+	_entryCount = 0;
+	_exitCount = 0;
+}
+
+void GraphReachability::Rebuild(SlotMap<Node*>& nodes, SlotMap<NodeConnection*>& connections)
+{
+	Clear();
+
+	_vertices.reserve(nodes.size());
+	_edges.reserve(connections.size());
+
+	for (const auto& [_, node] : nodes)
+		AddNode(node);
+
+	for (const auto& [_, connection] : connections)
+		AddConnection(connection);
+}
+
+void GraphReachability::AddNode(Node* node)
+{
+	AddVertex(node);
+
+	auto groupNode = node->AsGroup();
+	if (groupNode != nullptr)
+	{
+		for (const auto& child : groupNode->GetNodes())
+			AddChildNode(node, child);
+	}
+}
+
+void GraphReachability::RemoveNode(Node* node)
+{
+	auto groupNode = node->AsGroup();
+	if (groupNode != nullptr)
+	{
+		for (const auto& child : groupNode->GetNodes())
+			RemoveChildNode(node, child);
+	}
+
+	RemoveVertex(node);
+}
+
+void GraphReachability::AddChildNode(Node* parent, Node* child)
+{
+	AddVertex(child);
+	Link(parent, child);
+}
+
+void GraphReachability::RemoveChildNode(Node* parent, Node* child)
+{
+	Unlink(parent, child);
+	RemoveVertex(child);
+}
+
+void GraphReachability::AddConnection(NodeConnection* connection)
+{
+	if (_edges.find(connection) != _edges.end())
+		return;
+
+	auto from = connection->GetFrom()->GetNode();
+	auto to = connection->GetTo()->GetNode();
+
+	_edges.emplace(connection, std::make_pair(from, to));
+	Link(from, to);
+}
+
+void GraphReachability::RemoveConnection(NodeConnection* connection)
+{
+	auto it = _edges.find(connection);
+	if (it == _edges.end())
+		return;
+
+	auto [from, to] = it->second;
+	_edges.erase(it);
+	Unlink(from, to);
+}
+
+bool GraphReachability::IsReachable(Node* node) const
+{
+	if (_entryCount == 0)
+		return true;
+
+	auto it = _vertices.find(node);
+	return it != _vertices.end() && it->second.isReached;
+}
+
+bool GraphReachability::CanReachExit(Node* node) const
+{
+	if (_exitCount == 0)
+		return true;
+
+	auto it = _vertices.find(node);
+	return it != _vertices.end() && it->second.isCoreached;
+}
+
+void GraphReachability::AddVertex(Node* node)
+{
+	auto& vertex = _vertices[node];
+	if (vertex.isPresent)
+		return;
+
+	vertex.isPresent = true;
+
+	if (node->IsEntry())
+		_entryCount++;
+	if (node->IsExit())
+		_exitCount++;
+
+	// The vertex may still have edges from before it was removed (undo).
+	auto isReached = node->IsEntry();
+	for (const auto& [predecessor, _] : vertex.predecessors)
+		isReached = isReached || _vertices.at(predecessor).isReached;
+
+	auto isCoreached = node->IsExit();
+	for (const auto& [successor, _] : vertex.successors)
+		isCoreached = isCoreached || _vertices.at(successor).isCoreached;
+
+	std::vector<Node*> queue;
+
+	if (isReached)
+	{
+		vertex.isReached = true;
+		queue.push_back(node);
+		Propagate(queue, true);
+	}
+
+	if (isCoreached)
+	{
+		vertex.isCoreached = true;
+		queue.assign(1, node);
+		Propagate(queue, false);
+	}
+}
+
+void GraphReachability::RemoveVertex(Node* node)
+{
+	auto it = _vertices.find(node);
+	if (it == _vertices.end() || !it->second.isPresent)
+		return;
+
+	auto& vertex = it->second;
+	vertex.isPresent = false;
+
+	if (node->IsEntry())
+		_entryCount--;
+	if (node->IsExit())
+		_exitCount--;
+
+	if (vertex.isReached)
+		Invalidate(node, true);
+	if (vertex.isCoreached)
+		Invalidate(node, false);
+
+	EraseVertexIfUnused(node);
+}
+
+void GraphReachability::EraseVertexIfUnused(Node* node)
+{
+	auto it = _vertices.find(node);
+	if (it == _vertices.end())
+		return;
+
+	auto& vertex = it->second;
+	if (!vertex.isPresent && vertex.successors.empty() && vertex.predecessors.empty())
+		_vertices.erase(it);
+}
+
+void GraphReachability::Link(Node* from, Node* to)
+{
+	auto& vertexFrom = _vertices[from];
+	auto& vertexTo = _vertices[to];
+
+	vertexTo.predecessors[from]++;
+	if (++vertexFrom.successors[to] > 1)
+		return;
+
+	std::vector<Node*> queue;
+
+	if (vertexFrom.isReached && vertexTo.isPresent && !vertexTo.isReached)
+	{
+		vertexTo.isReached = true;
+		queue.push_back(to);
+		Propagate(queue, true);
+	}
+
+	if (vertexTo.isCoreached && vertexFrom.isPresent && !vertexFrom.isCoreached)
+	{
+		vertexFrom.isCoreached = true;
+		queue.assign(1, from);
+		Propagate(queue, false);
+	}
+}
+
+void GraphReachability::Unlink(Node* from, Node* to)
+{
+	auto itFrom = _vertices.find(from);
+	auto itTo = _vertices.find(to);
+	if (itFrom == _vertices.end() || itTo == _vertices.end())
+		return;
+
+	auto& vertexFrom = itFrom->second;
+	auto& vertexTo = itTo->second;
+
+	auto itSuccessor = vertexFrom.successors.find(to);
+	if (itSuccessor == vertexFrom.successors.end())
+		return;
+
+	auto itPredecessor = vertexTo.predecessors.find(from);
+	if (--itPredecessor->second == 0)
+		vertexTo.predecessors.erase(itPredecessor);
+
+	if (--itSuccessor->second == 0)
+	{
+		vertexFrom.successors.erase(itSuccessor);
+
+		if (vertexFrom.isReached && vertexTo.isReached)
+			Invalidate(to, true);
+
+		if (vertexFrom.isCoreached && vertexTo.isCoreached)
+			Invalidate(from, false);
+	}
+
+	EraseVertexIfUnused(from);
+	EraseVertexIfUnused(to);
+}
+
+void GraphReachability::Propagate(std::vector<Node*>& queue, bool forward)
+{
+	for (size_t i = 0; i < queue.size(); i++)
+	{
+		auto& vertex = _vertices.at(queue[i]);
+		auto& neighbours = forward ? vertex.successors : vertex.predecessors;
+
+		for (const auto& [neighbour, _] : neighbours)
+		{
+			auto& vertexNeighbour = _vertices.at(neighbour);
+			auto& isMarked = forward ? vertexNeighbour.isReached : vertexNeighbour.isCoreached;
+
+			if (vertexNeighbour.isPresent && !isMarked)
+			{
+				isMarked = true;
+				queue.push_back(neighbour);
+			}
+		}
+	}
+}
+
+void GraphReachability::Invalidate(Node* node, bool forward)
+{
+	auto isMarked = [forward](Vertex& vertex) -> bool& {
+		return forward ? vertex.isReached : vertex.isCoreached;
+		};
+
+	// Unmark everything that was marked through the given node...
+	std::vector<Node*> affected;
+	affected.push_back(node);
+	isMarked(_vertices.at(node)) = false;
+
+	for (size_t i = 0; i < affected.size(); i++)
+	{
+		auto& vertex = _vertices.at(affected[i]);
+		auto& neighbours = forward ? vertex.successors : vertex.predecessors;
+
+		for (const auto& [neighbour, _] : neighbours)
+		{
+			auto& vertexNeighbour = _vertices.at(neighbour);
+			if (isMarked(vertexNeighbour))
+			{
+				isMarked(vertexNeighbour) = false;
+				affected.push_back(neighbour);
+			}
+		}
+	}
+
+	// ...then re-derive the nodes that are still supported from outside the region.
+	std::vector<Node*> queue;
+	for (const auto& affectedNode : affected)
+	{
+		auto& vertex = _vertices.at(affectedNode);
+		if (!vertex.isPresent)
+			continue;
+
+		auto isSupported = forward ? affectedNode->IsEntry() : affectedNode->IsExit();
+		auto& neighbours = forward ? vertex.predecessors : vertex.successors;
+
+		for (const auto& [neighbour, _] : neighbours)
+			isSupported = isSupported || isMarked(_vertices.at(neighbour));
+
+		if (isSupported)
+		{
+			isMarked(vertex) = true;
+			queue.push_back(affectedNode);
+		}
+	}
+
+	Propagate(queue, forward);
+}
\ No newline at end of file
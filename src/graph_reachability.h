@@ -0,0 +1,64 @@
+#pragma once
+
+// std
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// local
+#include "node.h"
+#include "node_connection.h"
+#include "slot_map.h"
+
+// Tracks which nodes can be reached from an entry node (forward) and which
+// nodes can reach an exit node (backward). Group nodes are linked to their
+// children, so flow entering a group continues through the child slots.
+//
+// The analysis is kept up to date incrementally: adding edges only
+// propagates from the new edge, removing edges only invalidates and
+// re-derives the region downstream (or upstream) of the removed edge.
+class GraphReachability {
+public:
+	void Clear();
+	void Rebuild(SlotMap<Node*>& nodes, SlotMap<NodeConnection*>& connections);
+
+	void AddNode(Node* node);
+	void RemoveNode(Node* node);
+
+	void AddChildNode(Node* parent, Node* child);
+	void RemoveChildNode(Node* parent, Node* child);
+
+	void AddConnection(NodeConnection* connection);
+	void RemoveConnection(NodeConnection* connection);
+
+	// Nodes are only reported once the graph has at least one entry/exit node.
+	bool IsReachable(Node* node) const;
+	bool CanReachExit(Node* node) const;
+	inline bool IsDead(Node* node) const { return !IsReachable(node) || !CanReachExit(node); }
+
+private:
+	struct Vertex {
+		std::unordered_map<Node*, int> successors;
+		std::unordered_map<Node*, int> predecessors;
+
+		bool isPresent = false;
+		bool isReached = false;
+		bool isCoreached = false;
+	};
+
+	std::unordered_map<Node*, Vertex> _vertices;
+	std::unordered_map<NodeConnection*, std::pair<Node*, Node*>> _edges;
+
+	int _entryCount = 0;
+	int _exitCount = 0;
+
+	void AddVertex(Node* node);
+	void RemoveVertex(Node* node);
+	void EraseVertexIfUnused(Node* node);
+
+	void Link(Node* from, Node* to);
+	void Unlink(Node* from, Node* to);
+
+	void Propagate(std::vector<Node*>& queue, bool forward);
+	void Invalidate(Node* node, bool forward);
+};
\ No newline at end of file
@@ -0,0 +1,206 @@
+#include "graph_snapshot.h"
+
+static size_t GetRecordCount(const EncodedChunkArray& chunks)
+{
+	size_t count = 0;
+	for (const auto& chunk : chunks)
+	{
+		if (chunk != nullptr)
+			count += chunk->records.size();
+	}
+
+	return count;
+}
+
+static void ForEachRecord(const EncodedChunkArray& chunks, const GraphSnapshot::RecordCallback& callback)
+{
+	for (const auto& chunk : chunks)
+	{
+		if (chunk == nullptr)
+			continue;
+
+		for (const auto& [id, record] : chunk->records)
+			callback(id, record->encoded);
+	}
+}
+
+static const std::string* FindEncodedRecord(const EncodedChunkArray& chunks, const std::string& id)
+{
+	auto& chunk = chunks[GetEncodedChunkIndex(id)];
+	if (chunk == nullptr)
+		return nullptr;
+
+	auto it = chunk->records.find(id);
+	if (it == chunk->records.end())
+		return nullptr;
+
+	return &it->second->encoded;
+}
+
+static bool FindRecord(const EncodedChunkArray& chunks, const std::string& id, nlohmann::json& value)
+{
+	auto encoded = FindEncodedRecord(chunks, id);
+	if (encoded == nullptr)
+		return false;
+
+	value = nlohmann::json::parse(*encoded);
+	return true;
+}
+
+static bool SplitRecordLines(const std::string& data, const std::string& start, std::vector<std::string_view>& records)
+{
+	auto position = data.find(start);
+	if (position == std::string::npos)
+		return false;
+
+	position += start.size();
+	while (position < data.size())
+	{
+		auto end = data.find('\n', position);
+		if (end == std::string::npos)
+			end = data.size();
+
+		std::string_view line(data.data() + position, end - position);
+		position = end + 1;
+
+		// An empty array is written as "[\n\n]".
+		if (line.empty())
+			continue;
+		if (line.front() == ']')
+			return true;
+
+		if (line.back() == ',')
+			line.remove_suffix(1);
+		if (line.empty() || line.front() != '{' || line.back() != '}')
+			return false;
+
+		records.push_back(line);
+	}
+
+	return false;
+}
+
+static void AppendChunks(const EncodedChunkArray& chunks, std::string& data)
+{
+	bool isFirst = true;
+	for (const auto& chunk : chunks)
+	{
+		if (chunk == nullptr || chunk->encoded.empty())
+			continue;
+
+		if (!isFirst) data += ",\n";
+		data += chunk->encoded;
+		isFirst = false;
+	}
+}
+
+GraphSnapshot::GraphSnapshot(const EncodedChunkArray& nodes, const EncodedChunkArray& connections, int scale, float offsetX, float offsetY, uint64_t version, std::string header) :
+	_nodes(nodes),
+	_connections(connections),
+	_scale(scale),
+	_offsetX(offsetX),
+	_offsetY(offsetY),
+	_version(version),
+	_header(std::move(header))
+{
+}
+
+size_t GraphSnapshot::GetNodeCount() const
+{
+	return GetRecordCount(_nodes);
+}
+
+size_t GraphSnapshot::GetConnectionCount() const
+{
+	return GetRecordCount(_connections);
+}
+
+uint64_t GraphSnapshot::HashChunks(const EncodedChunkArray& nodes, const EncodedChunkArray& connections)
+{
+	uint64_t hash = HashEncoded(std::string());
+	for (const auto& chunks : { &nodes, &connections })
+	{
+		for (const auto& chunk : *chunks)
+		{
+			if (chunk != nullptr)
+				hash = CombineHash(hash, chunk->hash);
+		}
+	}
+
+	return hash;
+}
+
+void GraphSnapshot::ForEachNode(const RecordCallback& callback) const
+{
+	ForEachRecord(_nodes, callback);
+}
+
+void GraphSnapshot::ForEachConnection(const RecordCallback& callback) const
+{
+	ForEachRecord(_connections, callback);
+}
+
+bool GraphSnapshot::FindNode(const std::string& id, nlohmann::json& node) const
+{
+	return FindRecord(_nodes, id, node);
+}
+
+bool GraphSnapshot::FindConnection(const std::string& id, nlohmann::json& connection) const
+{
+	return FindRecord(_connections, id, connection);
+}
+
+const std::string* GraphSnapshot::FindEncodedNode(const std::string& id) const
+{
+	return FindEncodedRecord(_nodes, id);
+}
+
+const std::string* GraphSnapshot::FindEncodedConnection(const std::string& id) const
+{
+	return FindEncodedRecord(_connections, id);
+}
+
+std::string GraphSnapshot::Serialize() const
+{
+	using json = nlohmann::json;
+
+	size_t size = 128 + _header.size();
+	for (const auto& chunks : { &_nodes, &_connections })
+	{
+		for (const auto& chunk : *chunks)
+		{
+			if (chunk != nullptr)
+				size += chunk->encoded.size() + 2;
+		}
+	}
+
+	// One node/connection per line, after the header line.
+	std::string data;
+	data.reserve(size);
+
+	data += "{";
+	if (!_header.empty())
+	{
+		data += "\"header\":";
+		data += _header;
+		data += ",\n";
+	}
+	data += "\"nodes\":[\n";
+	AppendChunks(_nodes, data);
+	data += "\n],\"connections\":[\n";
+	AppendChunks(_connections, data);
+	data += "\n],\"scale\":";
+	data += json(_scale).dump();
+	data += ",\"offset_x\":";
+	data += json(_offsetX).dump();
+	data += ",\"offset_y\":";
+	data += json(_offsetY).dump();
+	data += "}";
+
+	return data;
+}
+
+bool GraphSnapshot::SplitRecords(const std::string& data, std::vector<std::string_view>& nodes, std::vector<std::string_view>& connections)
+{
+	return SplitRecordLines(data, "\"nodes\":[\n", nodes) && SplitRecordLines(data, "],\"connections\":[\n", connections);
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// external
+#include "json.h"
+
+// local
+#include "encoded_chunks.h"
+
+// Frozen, immutable view of a graph's saved state, taken by
+// NodesGraph::TakeSnapshot. Taking one only copies the chunk pointers, edits
+// made afterwards replace the chunks they touch instead of modifying them,
+// so a snapshot can be read from any thread without locking.
+class GraphSnapshot {
+public:
+	using RecordCallback = std::function<void(const std::string& id, const std::string& encoded)>;
+
+	GraphSnapshot() = default;
+	GraphSnapshot(const EncodedChunkArray& nodes, const EncodedChunkArray& connections, int scale, float offsetX, float offsetY, uint64_t version, std::string header = std::string());
+
+	inline bool IsValid() const { return _nodes[0] != nullptr; }
+	inline uint64_t GetVersion() const { return _version; }
+
+	size_t GetNodeCount() const;
+	size_t GetConnectionCount() const;
+	// Hash of the encoded nodes and connections, combined from the hashes of
+	// their chunks, which are combined from the hashes of their records. Equal
+	// for graphs with the same nodes and connections, the view isn't included.
+	inline uint64_t GetContentHash() const { return HashChunks(_nodes, _connections); }
+	static uint64_t HashChunks(const EncodedChunkArray& nodes, const EncodedChunkArray& connections);
+
+	// Records are passed encoded, nlohmann::json::parse them when needed.
+	void ForEachNode(const RecordCallback& callback) const;
+	void ForEachConnection(const RecordCallback& callback) const;
+	bool FindNode(const std::string& id, nlohmann::json& node) const;
+	bool FindConnection(const std::string& id, nlohmann::json& connection) const;
+	// Unparsed, valid as long as the snapshot is.
+	const std::string* FindEncodedNode(const std::string& id) const;
+	const std::string* FindEncodedConnection(const std::string& id) const;
+
+	// Encoded JSON object summarizing the graph, written alone on the first line
+	// of the document so it can be read without parsing the rest (see GraphProject).
+	inline const std::string& GetHeader() const { return _header; }
+
+	// The document NodesGraph::Serialize would have written at the time of the snapshot.
+	std::string Serialize() const;
+	// The node and connection records of a document written by Serialize, one
+	// per line, as they were encoded. False for any other layout.
+	static bool SplitRecords(const std::string& data, std::vector<std::string_view>& nodes, std::vector<std::string_view>& connections);
+
+private:
+	EncodedChunkArray _nodes;
+	EncodedChunkArray _connections;
+
+	int _scale = 0;
+	float _offsetX = 0;
+	float _offsetY = 0;
+	uint64_t _version = 0;
+	std::string _header;
+};
\ No newline at end of file
@@ -0,0 +1,238 @@
+#include "graph_templates.h"
+
+// std
+#include <functional>
+#include <unordered_map>
+
+// local
+#include "guid.h"
+#include "subgraph_cloner.h"
+
+TemplatePrototype::~TemplatePrototype()
+{
+	for (auto connection : connections)
+		delete connection;
+
+	for (auto node : nodes)
+		delete node;
+}
+
+TemplateLibrary::TemplateLibrary(GraphClipboard::CreateNode createNode) :
+	_createNode(std::move(createNode))
+{
+}
+
+std::string TemplateLibrary::Add(const std::string& name, std::string data, size_t nodeCount, const std::string& inputSlot, const std::string& outputSlot)
+{
+	GraphTemplate graphTemplate;
+	graphTemplate.id = Guid::CreateGuid();
+	graphTemplate.name = name;
+	graphTemplate.data = std::move(data);
+	graphTemplate.nodeCount = nodeCount;
+	graphTemplate.inputSlot = inputSlot;
+	graphTemplate.outputSlot = outputSlot;
+
+	auto id = graphTemplate.id;
+	_templates.emplace(id, std::move(graphTemplate));
+	_version++;
+
+	return id;
+}
+
+void TemplateLibrary::Remove(const std::string& id)
+{
+	if (_templates.erase(id) > 0)
+		_version++;
+}
+
+void TemplateLibrary::Clear()
+{
+	_templates.clear();
+	_version++;
+}
+
+const GraphTemplate* TemplateLibrary::Find(const std::string& id) const
+{
+	auto it = _templates.find(id);
+	return it != _templates.end() ? &it->second : nullptr;
+}
+
+const TemplatePrototype* TemplateLibrary::GetPrototype(const std::string& id)
+{
+	auto it = _templates.find(id);
+	if (it == _templates.end())
+		return nullptr;
+
+	auto& graphTemplate = it->second;
+	if (graphTemplate.prototype != nullptr)
+		return graphTemplate.prototype.get();
+
+	// The prototype keeps the ids from the data, overrides refer to them.
+	auto prototype = std::make_unique<TemplatePrototype>();
+	if (!GraphClipboard::Decode(graphTemplate.data, ImVec2(0, 0), _createNode, prototype->nodes, prototype->connections, false))
+		return nullptr;
+
+	for (auto connection : prototype->connections)
+		prototype->slotConnections.Add(connection);
+
+	std::function<void(Node*)> findBoundary = [&](Node* node) {
+		for (auto slot : node->GetSlots()) {
+			if (slot->GetId() == graphTemplate.inputSlot) prototype->input = slot;
+			if (slot->GetId() == graphTemplate.outputSlot) prototype->output = slot;
+		}
+
+		auto groupNode = node->AsGroup();
+		if (groupNode != nullptr) {
+			for (auto child : groupNode->GetNodes())
+				findBoundary(child);
+		}
+	};
+
+	for (auto node : prototype->nodes)
+		findBoundary(node);
+
+	graphTemplate.nodeCount = prototype->nodes.size();
+	graphTemplate.prototype = std::move(prototype);
+	return graphTemplate.prototype.get();
+}
+
+void TemplateLibrary::ApplyOverrides(Node* prototype, Node* clone, const nlohmann::json& overrides)
+{
+	auto it = overrides.find(prototype->GetId());
+	if (it != overrides.end() && it->is_object()) {
+		nlohmann::json jsonNode;
+		clone->ToJson(jsonNode);
+
+		for (const auto& [key, value] : it->items()) {
+			// The structure of the template can't be overridden.
+			if (key == "id" || key == "type" || key == "slots" || key == "nodes" || key == "x" || key == "y")
+				continue;
+
+			jsonNode[key] = value;
+		}
+
+		// Not the group version, which would create the children again.
+		clone->Node::FromJson(jsonNode);
+	}
+
+	auto groupNode = prototype->AsGroup();
+	auto groupClone = clone->AsGroup();
+	if (groupNode != nullptr && groupClone != nullptr) {
+		auto& children = groupNode->GetNodes();
+		auto& childClones = groupClone->GetNodes();
+		for (size_t i = 0; i < children.size() && i < childClones.size(); i++)
+			ApplyOverrides(children[i], childClones[i], overrides);
+	}
+}
+
+bool TemplateLibrary::Instantiate(const std::string& id, ImVec2 position, const nlohmann::json& overrides,
+	std::vector<Node*>& nodes, std::vector<NodeConnection*>& connections,
+	NodeSlot** input, NodeSlot** output)
+{
+	auto prototype = GetPrototype(id);
+	if (prototype == nullptr)
+		return false;
+
+	std::unordered_map<NodeSlot*, NodeSlot*> slots;
+	auto first = nodes.size();
+	SubgraphCloner::Clone(prototype->nodes, prototype->slotConnections, nodes, connections, &slots);
+
+	auto hasOverrides = overrides.is_object() && !overrides.empty();
+	for (size_t i = 0; i < prototype->nodes.size(); i++) {
+		auto clone = nodes[first + i];
+		if (hasOverrides)
+			ApplyOverrides(prototype->nodes[i], clone, overrides);
+
+		clone->SetPosition(clone->GetPosition() + position);
+		clone->SetRecordedPosition(clone->GetPosition());
+	}
+
+	if (input != nullptr)
+		*input = prototype->input != nullptr ? slots.at(prototype->input) : nullptr;
+	if (output != nullptr)
+		*output = prototype->output != nullptr ? slots.at(prototype->output) : nullptr;
+
+	return true;
+}
+
+std::string TemplateLibrary::Serialize() const
+{
+	// The data is already JSON, it is embedded as is instead of being parsed and dumped again.
+	std::string data = "{\"templates\":[\n";
+
+	bool isFirst = true;
+	for (const auto& [id, graphTemplate] : _templates)
+	{
+		nlohmann::json jsonTemplate;
+		jsonTemplate["id"] = id;
+		jsonTemplate["name"] = graphTemplate.name;
+		jsonTemplate["node_count"] = graphTemplate.nodeCount;
+		jsonTemplate["input"] = graphTemplate.inputSlot;
+		jsonTemplate["output"] = graphTemplate.outputSlot;
+
+		auto encoded = jsonTemplate.dump();
+		encoded.pop_back();
+
+		if (!isFirst) data += ",\n";
+		data += encoded + ",\"data\":" + graphTemplate.data + "}";
+		isFirst = false;
+	}
+
+	data += "\n]}";
+	return data;
+}
+
+bool TemplateLibrary::Deserialize(const std::string& data)
+{
+	using json = nlohmann::json;
+
+	json jsonLibrary = json::parse(data, nullptr, false);
+	if (jsonLibrary.is_discarded() || !jsonLibrary.contains("templates"))
+		return false;
+
+	_templates.clear();
+
+	// A damaged entry is dropped, the others are still loaded.
+	for (const auto& jsonTemplate : jsonLibrary["templates"])
+	{
+		GraphTemplate graphTemplate;
+		try
+		{
+			jsonTemplate.at("id").get_to(graphTemplate.id);
+			jsonTemplate.at("name").get_to(graphTemplate.name);
+			graphTemplate.nodeCount = jsonTemplate.value("node_count", (size_t)0);
+			graphTemplate.inputSlot = jsonTemplate.value("input", "");
+			graphTemplate.outputSlot = jsonTemplate.value("output", "");
+			graphTemplate.data = jsonTemplate.at("data").dump();
+		}
+		catch (const json::exception&)
+		{
+			continue;
+		}
+
+		auto id = graphTemplate.id;
+		_templates.emplace(id, std::move(graphTemplate));
+	}
+
+	_version++;
+	return true;
+}
+
+size_t TemplateLibrary::GetMemoryUsage() const
+{
+	size_t usage = sizeof(*this);
+	for (const auto& [id, graphTemplate] : _templates)
+	{
+		usage += sizeof(GraphTemplate) + id.capacity() + graphTemplate.name.capacity() + graphTemplate.data.capacity();
+
+		if (graphTemplate.prototype != nullptr)
+		{
+			for (auto node : graphTemplate.prototype->nodes)
+				usage += node->GetMemoryUsage();
+
+			usage += graphTemplate.prototype->connections.size() * sizeof(NodeConnection);
+		}
+	}
+
+	return usage;
+}
\ No newline at end of file
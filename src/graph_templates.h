@@ -0,0 +1,87 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// external
+#include <json.h>
+
+// local
+#include "node.h"
+#include "node_connection.h"
+#include "slot_connections.h"
+#include "slot_map.h"
+#include "graph_clipboard.h"
+
+// Nodes of a template, created once from its data and shared by every
+// instance. They are never added to a graph, instances are cloned from them.
+struct TemplatePrototype {
+	std::vector<Node*> nodes;
+	std::vector<NodeConnection*> connections;
+	SlotConnections slotConnections;
+
+	// Slots exposed by the instances, connections to the instance node are moved to them on expansion.
+	NodeSlot* input = nullptr;
+	NodeSlot* output = nullptr;
+
+	~TemplatePrototype();
+};
+
+struct GraphTemplate {
+	std::string id;
+	std::string name;
+	// Subgraph in the clipboard format, positions relative to its top left corner.
+	std::string data;
+	size_t nodeCount = 0;
+	// Ids of the boundary slots in `data`, empty if the template has none.
+	std::string inputSlot;
+	std::string outputSlot;
+
+	// Parsed on first use.
+	std::unique_ptr<TemplatePrototype> prototype;
+};
+
+// Subgraphs stored once and instanced into graphs by reference (TemplateNode).
+// Graphs only save the template id and the per-instance overrides, the nodes
+// are only created when an instance is expanded.
+//
+// Overrides are keyed by the id of a node in the template, each is an object
+// of fields (as written by Node::ToJson) replacing the template's values.
+class TemplateLibrary {
+public:
+	TemplateLibrary(GraphClipboard::CreateNode createNode);
+
+	std::string Add(const std::string& name, std::string data, size_t nodeCount, const std::string& inputSlot, const std::string& outputSlot);
+	void Remove(const std::string& id);
+	void Clear();
+
+	const GraphTemplate* Find(const std::string& id) const;
+	inline const SlotMap<GraphTemplate>& GetTemplates() const { return _templates; }
+	inline bool IsEmpty() const { return _templates.empty(); }
+
+	const TemplatePrototype* GetPrototype(const std::string& id);
+
+	// Appends clones of the template's nodes and connections, offset by
+	// `position`, with the overrides applied. Fails if the template is missing
+	// or its data can't be loaded.
+	bool Instantiate(const std::string& id, ImVec2 position, const nlohmann::json& overrides,
+		std::vector<Node*>& nodes, std::vector<NodeConnection*>& connections,
+		NodeSlot** input = nullptr, NodeSlot** output = nullptr);
+
+	std::string Serialize() const;
+	bool Deserialize(const std::string& data);
+
+	// Bumped whenever templates are added or removed, for saving the library when it changed.
+	inline uint64_t GetVersion() const { return _version; }
+	size_t GetMemoryUsage() const;
+
+private:
+	GraphClipboard::CreateNode _createNode;
+	SlotMap<GraphTemplate> _templates;
+	uint64_t _version = 0;
+
+	static void ApplyOverrides(Node* prototype, Node* clone, const nlohmann::json& overrides);
+};
\ No newline at end of file
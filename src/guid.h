@@ -7,7 +7,9 @@
 #include <uuid/uuid.h>
 #endif
 
+#include <cstdint>
 #include <iostream>
+#include <random>
 #include <string>
 
 class Guid {
@@ -34,9 +36,25 @@ public:
 	}
 #elif defined(__APPLE__) || defined(__linux__)
 	static std::string CreateGuid() {
+		// uuid_generate reads the system random source on every call, which
+		// dominates creating many nodes at once. Version 4 uuids only need
+		// random bits, so they come from a generator seeded once per thread.
+		thread_local std::mt19937_64 random = [] {
+			std::random_device device;
+			std::seed_seq seed{ device(), device(), device(), device(), device(), device(), device(), device() };
+			return std::mt19937_64(seed);
+		}();
 
 		uuid_t uuid;
-		uuid_generate(uuid);
+		uint64_t high = random();
+		uint64_t low = random();
+		for (int i = 0; i < 8; i++) {
+			uuid[i] = (unsigned char)(high >> (i * 8));
+			uuid[i + 8] = (unsigned char)(low >> (i * 8));
+		}
+
+		uuid[6] = (uuid[6] & 0x0F) | 0x40;
+		uuid[8] = (uuid[8] & 0x3F) | 0x80;
 
 		char uuid_str[37];
 		uuid_unparse(uuid, uuid_str);
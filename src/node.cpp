@@ -72,7 +72,7 @@ Node::~Node()
 
 void Node::AddSlot(ImVec2 relativePosition, bool isInput, bool isOutput)
 {
-	auto slot = new NodeSlot(relativePosition, isInput, isOutput);
+	auto slot = new NodeSlot(this, relativePosition, isInput, isOutput);
 	_slots.emplace_back(slot);
 }
 
@@ -157,7 +157,7 @@ void Node::PreDraw(ImDrawList* drawList)
 	_DrawAfter(drawList);
 
 	ImGui::EndGroup();
-	_size = ImGui::GetItemRectSize() + _padding * 2;
+	SetSize(ImGui::GetItemRectSize() + _padding * 2);
 	ImGui::PopID();
 	ImGui::PopStyleVar();
 }
@@ -167,10 +167,16 @@ void Node::Draw(ImDrawList* drawList, bool clipDetails)
 	ImGui::PushID(_id.c_str());
 
 	auto min = ImFloor(_position);
-	ImGui::SetCursorScreenPos(min + _padding);
 
-	// Foreground channel
+	// Everything of a node goes into one channel, so overlapping nodes stack in
+	// drawing order. The background is drawn first, with the size and state from
+	// the previous frame.
 	drawList->ChannelsSetCurrent(1);
+
+	auto colorBackground = (_isPressed || _isSelected) ? _colorSelected : _isHovered ? _colorHovered : _colorDefault;
+	drawList->AddRectFilled(min, min + _size, colorBackground, 1.0f);
+
+	ImGui::SetCursorScreenPos(min + _padding);
 	if (!clipDetails)
 	{
 		ImGui::BeginGroup();
@@ -183,11 +189,9 @@ void Node::Draw(ImDrawList* drawList, bool clipDetails)
 
 		ImGui::EndGroup();
 
-		_size = ImGui::GetItemRectSize() + _padding * 2;
+		SetSize(ImGui::GetItemRectSize() + _padding * 2);
 	}
 
-	// Background channel
-	drawList->ChannelsSetCurrent(0);
 	ImGui::SetCursorScreenPos(min);
 
 	auto max = min + _size;
@@ -198,12 +202,17 @@ void Node::Draw(ImDrawList* drawList, bool clipDetails)
 	_isHovered = ImGui::IsItemHovered();
 	_isPressed = ImGui::IsItemActive();
 
-	auto colorBackground = (_isPressed || _isSelected) ? _colorSelected : _isHovered ? _colorHovered : _colorDefault;
-	drawList->AddRectFilled(min, max, colorBackground, 1.0f);
+	if (_layout)
+		_layout->SetFlag(_layoutIndex, NodeLayout::Flags_Hovered, _isHovered);
+
 	drawList->AddRect(min, max, _colorOutline, 1.0f, 0, 1_dpi);
 
 	if (NodesGraphSettings::ValidateNodes()) {
 		_isValid = Validate();
+
+		if (_layout)
+			_layout->SetFlag(_layoutIndex, NodeLayout::Flags_Invalid, !_isValid);
+
 		if (!_isValid) {
 
 			drawList->AddRect(min, max, ImColor(255, 0, 0, 255), 0, 0, 1_dpi);
@@ -219,12 +228,22 @@ void Node::Draw(ImDrawList* drawList, bool clipDetails)
 	ImGui::PopID();
 }
 
+void Node::SetSize(const ImVec2& size)
+{
+	_size = size;
+
+	if (_layout)
+		_layout->SetSize(_layoutIndex, size);
+}
+
 Node* Node::Clone()
 {
 	auto clone = _Clone();
 	clone->Init();
 	clone->_id = Guid::CreateGuid();
 	clone->_type = _type;
+	clone->_typeId = _typeId;
+	clone->_typeFlags = _typeFlags;
 	clone->_label = _label;
 	clone->_size = _size;
 	clone->_position = _position;
@@ -232,6 +251,22 @@ Node* Node::Clone()
 	return clone;
 }
 
+size_t Node::GetMemoryUsage() const
+{
+	auto usage = _GetMemoryUsage() + _type.capacity() + _id.capacity() + _label.capacity() + _validationMessage.capacity();
+	usage += _slots.capacity() * sizeof(NodeSlot*) + _slots.size() * (sizeof(NodeSlot) + _id.size());
+	return usage;
+}
+
+size_t _GroupNode::GetMemoryUsage() const
+{
+	auto usage = Node::GetMemoryUsage() + _nodes.capacity() * sizeof(Node*);
+	for (const auto& node : _nodes) {
+		usage += node->GetMemoryUsage();
+	}
+	return usage;
+}
+
 Node* _GroupNode::Clone()
 {
 	auto clone = (_GroupNode*)Node::Clone();
@@ -12,8 +12,32 @@
 
 // local
 #include "node_slot.h"
+#include "node_layout.h"
 #include "literals.h"
 
+// A lookup key declared by a node, e.g. the id of a connector. Definitions
+// are the targets of "go to", references point at a definition by name/value.
+struct NodeKey {
+	enum Role {
+		Definition,
+		Reference
+	};
+
+	std::string name;
+	std::string value;
+	Role role;
+};
+
+// Properties shared by all nodes of a registered type, see NodesGraph::RegisterNode.
+enum NodeTypeFlags {
+	NodeTypeFlags_None = 0,
+	NodeTypeFlags_Group = 1 << 0,
+	NodeTypeFlags_Entry = 1 << 1,
+	NodeTypeFlags_Exit = 1 << 2
+};
+
+class _GroupNode;
+
 class Node {
 public:
 	Node();
@@ -25,18 +49,31 @@ public:
 	virtual void PreDraw(ImDrawList* drawList);
 	virtual Node* Clone();
 
-	inline std::string GetId() const { return _id; };
+	inline const std::string& GetId() const { return _id; };
+	inline const std::string& GetLabel() const { return _label; };
 	inline ImVec2 GetPosition() const { return _position; };
 	inline ImVec2 GetRecordedPosition() const { return _recordedPosition; };
 	inline ImVec2 GetSize() const { return _size; };
 	inline std::vector<NodeSlot*>& GetSlots() { return _slots; };
 
+	inline int GetTypeId() const { return _typeId; };
+	inline int GetTypeFlags() const { return _typeFlags; };
+	inline bool IsGroup() const { return _typeFlags & NodeTypeFlags_Group; };
+	inline _GroupNode* AsGroup();
+
 	inline void SetType(std::string type) { _type = type; };
+	inline void SetTypeInfo(int typeId, int typeFlags) { _typeId = typeId; _typeFlags = typeFlags; };
 	inline void SetLabel(std::string label) { _label = label; };
-	inline void SetPosition(const ImVec2& position) { _position = position; };
+	inline void SetPosition(const ImVec2& position) {
+		_position = position;
+		if (_layout) _layout->SetPosition(_layoutIndex, position);
+	};
 	inline void SetRecordedPosition(const ImVec2& position) { _recordedPosition = position; };
 	inline std::string GetValidationMessage() const { return _validationMessage; };
 
+	inline bool IsEntry() const { return _isEntry; };
+	inline bool IsExit() const { return _isExit; };
+
 	inline bool IsValid() const { return _isValid; };
 	inline bool IsValidationCircleHovered() const { return _isErrorCircleHovered; };
 
@@ -44,11 +81,24 @@ public:
 	inline bool IsPressed() const { return _isPressed; };
 	inline bool IsSelected() const { return _isSelected; };
 
-	inline void SetIsSelected(bool value) { _isSelected = value; };
+	inline void SetIsSelected(bool value) {
+		_isSelected = value;
+		if (_layout) _layout->SetSelected(_layoutIndex, value);
+	};
+
+	inline NodeLayout* GetLayout() const { return _layout; };
+	inline int GetLayoutIndex() const { return _layoutIndex; };
+	inline void SetLayout(NodeLayout* layout, int index) { _layout = layout; _layoutIndex = index; };
 
 	virtual void ToJson(nlohmann::json& j);
 	virtual void FromJson(const nlohmann::json& j);
 
+	inline void GetKeys(std::vector<NodeKey>& keys) { _GetKeys(keys); };
+	inline void GetSearchFields(std::vector<std::string>& fields) { _GetSearchFields(fields); };
+
+	// Approximate heap footprint, used to budget the undo history.
+	virtual size_t GetMemoryUsage() const;
+
 private:
 	ImVec2 _recordedPosition;
 	ImVec2 _position;
@@ -57,6 +107,12 @@ private:
 	std::string _type;
 	std::string _id;
 
+	int _typeId = -1;
+	int _typeFlags = NodeTypeFlags_None;
+
+	NodeLayout* _layout = nullptr;
+	int _layoutIndex = -1;
+
 	std::string _validationMessage;
 	bool _isValid = true;
 	bool _isErrorCircleHovered = false;
@@ -68,6 +124,7 @@ private:
 	std::vector<NodeSlot*> _slots;
 
 	bool Validate();
+	void SetSize(const ImVec2& size);
 
 protected:
 	ImColor _colorSelected = IM_COL32(48, 48, 48, 255);
@@ -78,6 +135,10 @@ protected:
 
 	bool _outputRequired = true;
 	bool _inputRequired = true;
+
+	// Entry and exit nodes are the roots of the reachability analysis.
+	bool _isEntry = false;
+	bool _isExit = false;
 	std::string _label;
 
 	virtual void _Init() = 0;
@@ -88,6 +149,10 @@ protected:
 	virtual void _FromJson(const nlohmann::json& j) = 0;
 	virtual bool _Validate() { return true; };
 	virtual Node* _Clone() = 0;
+	inline virtual void _GetKeys(std::vector<NodeKey>& keys) {};
+	inline virtual void _GetSearchFields(std::vector<std::string>& fields) {};
+	// Size of the dynamic type and the heap its fields hold, see GetMemoryUsage.
+	inline virtual size_t _GetMemoryUsage() const { return sizeof(Node); };
 
 	inline void SetValidationMessage(const std::string message) { _validationMessage = message; }
 	void AddSlot(ImVec2 relativePosition, bool isInput = true, bool isOutput = true);
@@ -117,15 +182,19 @@ protected:
 	virtual void _ToJson(nlohmann::json& j) override = 0;
 	virtual void _FromJson(const nlohmann::json& j) override = 0;
 	virtual Node* _Clone() override = 0;
+	inline virtual size_t _GetMemoryUsage() const override { return sizeof(_GroupNode); };
 
 public:
-	_GroupNode() : _createdNode(nullptr) {}
+	_GroupNode() : _createdNode(nullptr) {
+		SetTypeInfo(-1, NodeTypeFlags_Group);
+	}
 
 	inline Node* GetCreatedNode() { return _createdNode; };
 	inline std::vector<Node*>& GetNodes() { return _nodes; };
 	inline ImVec2 GetDummySize() const { return _dummySize; }
 
 	virtual Node* Clone() override;
+	virtual size_t GetMemoryUsage() const override;
 
 	virtual ~_GroupNode() override {
 		for (auto node : _nodes) {
@@ -134,6 +203,11 @@ public:
 	}
 };
 
+inline _GroupNode* Node::AsGroup()
+{
+	return IsGroup() ? static_cast<_GroupNode*>(this) : nullptr;
+}
+
 template<DerivedFromNode T>
 class GroupNode : public _GroupNode {
 protected:
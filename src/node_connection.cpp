@@ -125,3 +125,11 @@ NodeConnection::NodeConnection(NodeSlot* from, NodeSlot* to) :
 {
 	_id = Guid::CreateGuid();
 }
+
+NodeConnection* NodeConnection::Clone(NodeSlot* from, NodeSlot* to) const
+{
+	auto clone = new NodeConnection(from, to);
+	clone->_type = _type;
+	clone->_value = _value;
+	return clone;
+}
@@ -34,8 +34,10 @@ private:
 
 public:
 	NodeConnection(NodeSlot* from, NodeSlot* to);
+	// A connection with a new id and the same type and value, between other slots.
+	NodeConnection* Clone(NodeSlot* from, NodeSlot* to) const;
 
-	inline std::string GetId() const { return _id; };
+	inline const std::string& GetId() const { return _id; };
 	inline NodeSlot* GetFrom() const { return _from; };
 	inline void SetFrom(NodeSlot* slot) { _from = slot; };
 	inline NodeSlot* GetTo() const { return _to; };
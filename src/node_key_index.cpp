@@ -0,0 +1,153 @@
+#include "node_key_index.h"
+
+// std
+#include <algorithm>
+
+void NodeKeyIndex::Clear()
+{
+	_entries.clear();
+	_nodeKeys.clear();
+	_duplicates.clear();
+	_orphans.clear();
+}
+
+void NodeKeyIndex::Rebuild(SlotMap<Node*>& nodes)
+{
+	Clear();
+
+	for (const auto& [_, node] : nodes)
+		Add(node);
+}
+
+void NodeKeyIndex::Add(Node* node)
+{
+	AddKeys(node);
+
+	auto groupNode = node->AsGroup();
+	if (groupNode != nullptr)
+	{
+		for (const auto& child : groupNode->GetNodes())
+			AddKeys(child);
+	}
+}
+
+void NodeKeyIndex::Remove(Node* node)
+{
+	RemoveKeys(node);
+
+	auto groupNode = node->AsGroup();
+	if (groupNode != nullptr)
+	{
+		for (const auto& child : groupNode->GetNodes())
+			RemoveKeys(child);
+	}
+}
+
+void NodeKeyIndex::Update(Node* node)
+{
+	RemoveKeys(node);
+	AddKeys(node);
+}
+
+Node* NodeKeyIndex::FindDefinition(const std::string& name, const std::string& value) const
+{
+	auto& definitions = GetDefinitions(name, value);
+	return definitions.empty() ? nullptr : definitions.front();
+}
+
+const std::vector<Node*>& NodeKeyIndex::GetDefinitions(const std::string& name, const std::string& value) const
+{
+	auto it = _entries.find(MakeKey(name, value));
+	return it != _entries.end() ? it->second.definitions : _empty;
+}
+
+const std::vector<Node*>& NodeKeyIndex::GetReferences(const std::string& name, const std::string& value) const
+{
+	auto it = _entries.find(MakeKey(name, value));
+	return it != _entries.end() ? it->second.references : _empty;
+}
+
+bool NodeKeyIndex::IsDuplicate(const std::string& name, const std::string& value) const
+{
+	return _duplicates.find(MakeKey(name, value)) != _duplicates.end();
+}
+
+bool NodeKeyIndex::IsOrphaned(const std::string& name, const std::string& value) const
+{
+	return _orphans.find(MakeKey(name, value)) != _orphans.end();
+}
+
+void NodeKeyIndex::GetExternalKeys(std::vector<NodeKey>& keys) const
+{
+	for (const auto& [key, entry] : _entries)
+	{
+		auto separator = key.find('\x1f');
+		auto role = entry.definitions.empty() ? NodeKey::Reference : NodeKey::Definition;
+		keys.push_back({ key.substr(0, separator), key.substr(separator + 1), role });
+	}
+}
+
+void NodeKeyIndex::AddKeys(Node* node)
+{
+	std::vector<NodeKey> keys;
+	node->GetKeys(keys);
+
+	if (keys.empty())
+		return;
+
+	for (const auto& nodeKey : keys)
+	{
+		auto key = MakeKey(nodeKey.name, nodeKey.value);
+		auto& entry = _entries[key];
+
+		if (nodeKey.role == NodeKey::Definition)
+			entry.definitions.push_back(node);
+		else
+			entry.references.push_back(node);
+
+		RefreshEntry(key);
+	}
+
+	_nodeKeys[node] = std::move(keys);
+}
+
+void NodeKeyIndex::RemoveKeys(Node* node)
+{
+	auto it = _nodeKeys.find(node);
+	if (it == _nodeKeys.end())
+		return;
+
+	for (const auto& nodeKey : it->second)
+	{
+		auto key = MakeKey(nodeKey.name, nodeKey.value);
+		auto& entry = _entries.at(key);
+		auto& nodes = nodeKey.role == NodeKey::Definition ? entry.definitions : entry.references;
+
+		auto itNode = std::find(nodes.begin(), nodes.end(), node);
+		if (itNode != nodes.end())
+			nodes.erase(itNode);
+
+		RefreshEntry(key);
+	}
+
+	_nodeKeys.erase(it);
+}
+
+void NodeKeyIndex::RefreshEntry(const std::string& key)
+{
+	auto it = _entries.find(key);
+	auto& entry = it->second;
+
+	if (entry.definitions.size() > 1)
+		_duplicates.insert(key);
+	else
+		_duplicates.erase(key);
+
+	if (entry.definitions.empty() && !entry.references.empty())
+		_orphans.insert(key);
+	else
+		_orphans.erase(key);
+
+	if (entry.definitions.empty() && entry.references.empty())
+		_entries.erase(it);
+}
\ No newline at end of file
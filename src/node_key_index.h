@@ -0,0 +1,58 @@
+#pragma once
+
+// std
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// local
+#include "node.h"
+#include "slot_map.h"
+
+// Cross-reference index over the keys declared by nodes (Node::_GetKeys).
+// Lookups by key, duplicate definitions and orphaned references are all O(1).
+class NodeKeyIndex {
+public:
+	void Clear();
+	void Rebuild(SlotMap<Node*>& nodes);
+
+	// Add/Remove include the children of group nodes, Update only re-reads the given node.
+	void Add(Node* node);
+	void Remove(Node* node);
+	void Update(Node* node);
+
+	Node* FindDefinition(const std::string& name, const std::string& value) const;
+	const std::vector<Node*>& GetDefinitions(const std::string& name, const std::string& value) const;
+	const std::vector<Node*>& GetReferences(const std::string& name, const std::string& value) const;
+
+	bool IsDuplicate(const std::string& name, const std::string& value) const;
+	bool IsOrphaned(const std::string& name, const std::string& value) const;
+
+	// What other graphs can link to: every defined key, as a Definition, and
+	// every reference without a definition here, as a Reference.
+	void GetExternalKeys(std::vector<NodeKey>& keys) const;
+
+	inline size_t GetDuplicateCount() const { return _duplicates.size(); }
+	inline size_t GetOrphanCount() const { return _orphans.size(); }
+
+private:
+	struct Entry {
+		std::vector<Node*> definitions;
+		std::vector<Node*> references;
+	};
+
+	std::unordered_map<std::string, Entry> _entries;
+	std::unordered_map<Node*, std::vector<NodeKey>> _nodeKeys;
+
+	std::unordered_set<std::string> _duplicates;
+	std::unordered_set<std::string> _orphans;
+
+	inline static const std::vector<Node*> _empty;
+
+	inline static std::string MakeKey(const std::string& name, const std::string& value) { return name + '\x1f' + value; }
+
+	void AddKeys(Node* node);
+	void RemoveKeys(Node* node);
+	void RefreshEntry(const std::string& key);
+};
\ No newline at end of file
@@ -0,0 +1,294 @@
+#include "node_layout.h"
+#include "node.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+
+void NodeLayout::Clear()
+{
+	for (const auto& node : _nodes)
+		node->SetLayout(nullptr, -1);
+
+	_nodes.clear();
+	_x.clear();
+	_y.clear();
+	_w.clear();
+	_h.clear();
+	_flags.clear();
+	_selected.clear();
+	_selectedCount = 0;
+
+	_order.clear();
+	_orderIndex.clear();
+	_removedOrderCount = 0;
+
+	_grid.clear();
+	_isGridDirty = true;
+}
+
+void NodeLayout::Rebuild(SlotMap<Node*>& nodes)
+{
+	// Nodes that are still there keep their drawing order, new ones go on top.
+	std::vector<Node*> ordered;
+	ordered.reserve(_nodes.size());
+
+	for (auto index : _order) {
+		if (index >= 0)
+			ordered.push_back(_nodes[index]);
+	}
+
+	Clear();
+
+	_nodes.reserve(nodes.size());
+	_x.reserve(nodes.size());
+	_y.reserve(nodes.size());
+	_w.reserve(nodes.size());
+	_h.reserve(nodes.size());
+	_flags.reserve(nodes.size());
+	_order.reserve(nodes.size());
+	_orderIndex.reserve(nodes.size());
+
+	for (auto node : ordered) {
+		auto it = nodes.find(node->GetId());
+		if (it != nodes.end() && it->second == node)
+			Add(node);
+	}
+
+	for (const auto& [_, node] : nodes)
+		Add(node);
+}
+
+void NodeLayout::Add(Node* node)
+{
+	if (node->GetLayout() != nullptr)
+		return;
+
+	auto index = (int)_nodes.size();
+	auto position = node->GetPosition();
+	auto size = node->GetSize();
+
+	_nodes.push_back(node);
+	_x.push_back(position.x);
+	_y.push_back(position.y);
+	_w.push_back(size.x);
+	_h.push_back(size.y);
+	_flags.push_back(0);
+
+	if (_selected.size() * 64 < _nodes.size())
+		_selected.push_back(0);
+
+	_orderIndex.push_back((int)_order.size());
+	_order.push_back(index);
+
+	SetSelected(index, node->IsSelected());
+	SetFlag(index, Flags_Hovered, node->IsHovered());
+	SetFlag(index, Flags_Invalid, !node->IsValid());
+
+	node->SetLayout(this, index);
+	_isGridDirty = true;
+}
+
+void NodeLayout::Remove(Node* node)
+{
+	if (node->GetLayout() != this)
+		return;
+
+	// Swap with the last element to keep the arrays dense.
+	auto index = node->GetLayoutIndex();
+	int last = (int)_nodes.size() - 1;
+
+	_order[_orderIndex[index]] = -1;
+	_removedOrderCount++;
+
+	SetSelected(index, false);
+	if (index != last && IsSelected(last))
+	{
+		SetSelected(last, false);
+		SetSelected(index, true);
+	}
+
+	if (index != last)
+	{
+		_nodes[index] = _nodes[last];
+		_x[index] = _x[last];
+		_y[index] = _y[last];
+		_w[index] = _w[last];
+		_h[index] = _h[last];
+		_flags[index] = _flags[last];
+		_orderIndex[index] = _orderIndex[last];
+
+		_nodes[index]->SetLayout(this, index);
+		_order[_orderIndex[index]] = index;
+	}
+
+	_nodes.pop_back();
+	_x.pop_back();
+	_y.pop_back();
+	_w.pop_back();
+	_h.pop_back();
+	_flags.pop_back();
+	_orderIndex.pop_back();
+
+	if (_selected.size() * 64 >= _nodes.size() + 64)
+		_selected.pop_back();
+
+	_isGridDirty = true;
+
+	node->SetLayout(nullptr, -1);
+}
+
+void NodeLayout::BringToFront(size_t index)
+{
+	if (_orderIndex[index] == (int)_order.size() - 1)
+		return;
+
+	_order[_orderIndex[index]] = -1;
+	_removedOrderCount++;
+
+	_orderIndex[index] = (int)_order.size();
+	_order.push_back((int)index);
+}
+
+void NodeLayout::CompactOrder()
+{
+	if (_removedOrderCount <= _nodes.size())
+		return;
+
+	size_t count = 0;
+	for (auto index : _order)
+	{
+		if (index < 0) continue;
+
+		_orderIndex[index] = (int)count;
+		_order[count++] = index;
+	}
+
+	_order.resize(count);
+	_removedOrderCount = 0;
+}
+
+int NodeLayout::Cull(const ImVec2& viewMin, const ImVec2& viewMax, std::vector<uint8_t>& sides) const
+{
+	auto count = _nodes.size();
+	sides.resize(count);
+
+	const float* x = _x.data();
+	const float* y = _y.data();
+	const float* w = _w.data();
+	const float* h = _h.data();
+	uint8_t* result = sides.data();
+
+	int any = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		int side =
+			(x[i] + w[i] < viewMin.x ? Sides_Left : 0) |
+			(x[i] > viewMax.x ? Sides_Right : 0) |
+			(y[i] + h[i] < viewMin.y ? Sides_Top : 0) |
+			(y[i] > viewMax.y ? Sides_Bottom : 0);
+
+		result[i] = (uint8_t)side;
+		any |= side;
+	}
+
+	return any;
+}
+
+void NodeLayout::SetSelected(size_t index, bool value)
+{
+	auto& word = _selected[index / 64];
+	auto bit = 1ull << (index % 64);
+
+	if (((word & bit) != 0) == value)
+		return;
+
+	word ^= bit;
+	_selectedCount += value ? 1 : -1;
+}
+
+void NodeLayout::Query(const ImVec2& rectMin, const ImVec2& rectMax, std::vector<int>& result)
+{
+	result.clear();
+
+	if (_isGridDirty)
+		RebuildGrid();
+
+	if (++_queryStamp == 0) {
+		std::fill(_queryStamps.begin(), _queryStamps.end(), 0);
+		_queryStamp = 1;
+	}
+
+	auto minX = (int)std::floor(rectMin.x / GridCellSize);
+	auto minY = (int)std::floor(rectMin.y / GridCellSize);
+	auto maxX = (int)std::floor(rectMax.x / GridCellSize);
+	auto maxY = (int)std::floor(rectMax.y / GridCellSize);
+
+	// A huge rectangle touches more cells than there are nodes, scanning them is cheaper then.
+	if ((int64_t)(maxX - minX + 1) * (maxY - minY + 1) > (int64_t)_grid.size())
+	{
+		for (size_t i = 0; i < _nodes.size(); i++)
+		{
+			if (Overlaps(i, rectMin, rectMax))
+				result.push_back((int)i);
+		}
+
+		return;
+	}
+
+	for (int y = minY; y <= maxY; y++)
+	{
+		for (int x = minX; x <= maxX; x++)
+		{
+			auto it = _grid.find(GetCellKey(x, y));
+			if (it == _grid.end()) continue;
+
+			for (auto index : it->second)
+			{
+				if (_queryStamps[index] == _queryStamp) continue;
+				_queryStamps[index] = _queryStamp;
+
+				if (Overlaps(index, rectMin, rectMax))
+					result.push_back(index);
+			}
+		}
+	}
+}
+
+bool NodeLayout::Overlaps(size_t index, const ImVec2& rectMin, const ImVec2& rectMax) const
+{
+	// Same test as ImRect::Overlaps.
+	return rectMin.y < _y[index] + _h[index] && rectMax.y > _y[index] && rectMin.x < _x[index] + _w[index] && rectMax.x > _x[index];
+}
+
+void NodeLayout::RebuildGrid()
+{
+	for (auto& [_, cell] : _grid)
+		cell.clear();
+
+	for (size_t i = 0; i < _nodes.size(); i++)
+	{
+		auto minX = (int)std::floor(_x[i] / GridCellSize);
+		auto minY = (int)std::floor(_y[i] / GridCellSize);
+		auto maxX = (int)std::floor((_x[i] + _w[i]) / GridCellSize);
+		auto maxY = (int)std::floor((_y[i] + _h[i]) / GridCellSize);
+
+		for (int y = minY; y <= maxY; y++)
+		{
+			for (int x = minX; x <= maxX; x++)
+				_grid[GetCellKey(x, y)].push_back((int)i);
+		}
+	}
+
+	// Cells left empty by moved nodes would otherwise pile up.
+	std::erase_if(_grid, [](const auto& cell) { return cell.second.empty(); });
+
+	_queryStamps.assign(_nodes.size(), 0);
+	_queryStamp = 0;
+	_isGridDirty = false;
+}
+
+uint64_t NodeLayout::GetCellKey(int x, int y)
+{
+	return ((uint64_t)(uint32_t)x << 32) | (uint32_t)y;
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#pragma once
+
+// external
+#define IMGUI_DEFINE_MATH_OPERATORS
+#include <imgui.h>
+
+// std
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// local
+#include "slot_map.h"
+
+class Node;
+
+// Structure-of-arrays mirror of the top level nodes' bounds and state flags.
+// Node::SetPosition, size updates and state changes write through to it, so
+// per-frame passes (culling, rectangle selection, ...) can scan contiguous
+// arrays instead of following node pointers.
+class NodeLayout {
+public:
+	enum Flags {
+		Flags_Hovered = 1 << 0,
+		Flags_Invalid = 1 << 1
+	};
+
+	enum Sides {
+		Sides_Left = 1 << 0,
+		Sides_Right = 1 << 1,
+		Sides_Top = 1 << 2,
+		Sides_Bottom = 1 << 3
+	};
+
+	void Clear();
+	void Rebuild(SlotMap<Node*>& nodes);
+
+	void Add(Node* node);
+	void Remove(Node* node);
+
+	inline size_t Size() const { return _nodes.size(); }
+	inline Node* GetNode(size_t index) const { return _nodes[index]; }
+
+	inline ImVec2 GetPosition(size_t index) const { return ImVec2(_x[index], _y[index]); }
+	inline ImVec2 GetSize(size_t index) const { return ImVec2(_w[index], _h[index]); }
+	inline bool HasFlag(size_t index, Flags flag) const { return _flags[index] & flag; }
+	inline bool IsSelected(size_t index) const { return _selected[index / 64] & (1ull << (index % 64)); }
+	inline size_t GetSelectedCount() const { return _selectedCount; }
+
+	inline void SetPosition(size_t index, const ImVec2& position) {
+		if (_x[index] == position.x && _y[index] == position.y) return;
+		_x[index] = position.x; _y[index] = position.y;
+		_isGridDirty = true;
+	}
+
+	inline void SetSize(size_t index, const ImVec2& size) {
+		if (_w[index] == size.x && _h[index] == size.y) return;
+		_w[index] = size.x; _h[index] = size.y;
+		_isGridDirty = true;
+	}
+
+	inline void SetFlag(size_t index, Flags flag, bool value) { _flags[index] = value ? (_flags[index] | flag) : (_flags[index] & ~flag); }
+	void SetSelected(size_t index, bool value);
+
+	// Back to front drawing order, as node indices. Entries of nodes removed or
+	// brought to the front since the last CompactOrder are -1 and must be skipped.
+	inline const std::vector<int>& GetOrder() const { return _order; }
+	void BringToFront(size_t index);
+	// Drops the -1 entries once they outnumber the nodes, so reordering stays O(1) amortized.
+	void CompactOrder();
+
+	// Writes, per node, which sides of the view rectangle the node lies beyond (0 when visible).
+	// Returns the union of all sides.
+	int Cull(const ImVec2& viewMin, const ImVec2& viewMax, std::vector<uint8_t>& sides) const;
+
+	// Writes the indices of the nodes overlapping the rectangle. Backed by a
+	// uniform grid, rebuilt by the first query after nodes moved, were resized,
+	// added or removed.
+	void Query(const ImVec2& rectMin, const ImVec2& rectMax, std::vector<int>& result);
+	bool Overlaps(size_t index, const ImVec2& rectMin, const ImVec2& rectMax) const;
+
+private:
+	std::vector<Node*> _nodes;
+
+	std::vector<float> _x;
+	std::vector<float> _y;
+	std::vector<float> _w;
+	std::vector<float> _h;
+	std::vector<uint8_t> _flags;
+	// One bit per node.
+	std::vector<uint64_t> _selected;
+	size_t _selectedCount = 0;
+
+	std::vector<int> _order;
+	std::vector<int> _orderIndex;
+	size_t _removedOrderCount = 0;
+
+	inline static constexpr float GridCellSize = 512.0f;
+	std::unordered_map<uint64_t, std::vector<int>> _grid;
+	bool _isGridDirty = true;
+	// Nodes spanning several cells are only reported once per query.
+	std::vector<uint32_t> _queryStamps;
+	uint32_t _queryStamp = 0;
+
+	void RebuildGrid();
+	static uint64_t GetCellKey(int x, int y);
+};
\ No newline at end of file
@@ -3,7 +3,8 @@
 
 #include "imgui_internal.h"
 
-NodeSlot::NodeSlot(ImVec2 positionRelative, bool isInput, bool isOutput) :
+NodeSlot::NodeSlot(Node* node, ImVec2 positionRelative, bool isInput, bool isOutput) :
+	_node(node),
 	_positionRelative(positionRelative),
 	_isInput(isInput),
 	_isOutput(isOutput)
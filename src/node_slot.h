@@ -10,8 +10,12 @@
 // std
 #include <string>
 
+class Node;
+
 class NodeSlot {
 private:
+	Node* _node;
+
 	ImVec2 _positionRelative;
 	ImVec2 _position;
 
@@ -31,10 +35,11 @@ private:
 	ImColor _colorPressed = IM_COL32(224, 224, 224, 150);
 
 public:
-	NodeSlot(ImVec2 positionRelative, bool isInput, bool isOutput);
+	NodeSlot(Node* node, ImVec2 positionRelative, bool isInput, bool isOutput);
 	void Draw(ImDrawList* drawList, ImVec2 nodePos, ImVec2 nodeSize, bool isEnabled, bool clipDetails);
 
-	inline std::string GetId() const { return _id; };
+	inline const std::string& GetId() const { return _id; };
+	inline Node* GetNode() const { return _node; };
 	inline ImVec2 GetRelativePosition() const { return _positionRelative; };
 	inline ImVec2 GetPosition() const { return _position; };
 	inline bool IsHovered() const { return _isHovered; };
@@ -1,6 +1,7 @@
 #include "nodes_graph.h"
 
 // std
+#include <algorithm>
 #include <fstream>
 #include <cmath>
 
@@ -9,17 +10,26 @@
 #include <imgui_internal.h>
 #include <json.h>
 
+// local
+#include "guid.h"
+#include "subgraph_cloner.h"
+#include "subgraph_node.h"
+#include "template_node.h"
+
 // commands
 #include "commands/create_node_command.h"
+#include "commands/create_nodes_command.h"
 #include "commands/create_child_node_command.h"
 #include "commands/delete_node_command.h"
 #include "commands/delete_child_node_command.h"
 #include "commands/move_node_command.h"
+#include "commands/move_nodes_command.h"
 #include "commands/move_child_node_command.h"
 #include "commands/create_connection_command.h"
 #include "commands/delete_connection_command.h"
 #include "commands/edit_connection_command.h"
 #include "commands/edit_value_command.h"
+#include "commands/edit_subgraph_command.h"
 
 #define min(x, y) (((x) < (y)) ? (x) : (y))
 #define max(x, y) (((x) > (y)) ? (x) : (y))
@@ -32,6 +42,11 @@ const char* CHILD_NODE_CONTEXT_MENU = "CHILD_NODE_CONTEXT_MENU";
 const char* CANVAS_CONTEXT_MENU = "CANVAS_CONTEXT_MENU";
 const char* CONNECTION_CONTEXT_MENU = "CONNECTION_CONTEXT_MENU";
 
+NodesGraph::NodesGraph() :
+	_id(Guid::CreateGuid())
+{
+}
+
 NodesGraph::~NodesGraph()
 {
 	for (auto& [_, node] : _nodes)
@@ -46,13 +61,33 @@ NodesGraph::~NodesGraph()
 }
 
 void NodesGraph::Draw()
+{
+	if (_enteredSubgraph == nullptr) {
+		DrawCanvas();
+		return;
+	}
+
+	DrawSubgraphPath();
+
+	auto windowFlags = ImGuiWindowFlags_NoScrollbar | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoScrollWithMouse;
+	ImGui::BeginChild("Subgraph", ImVec2(0, 0), ImGuiChildFlags_None, windowFlags);
+	GetActiveGraph()->DrawCanvas();
+	ImGui::EndChild();
+}
+
+void NodesGraph::DrawCanvas()
 {
 	_current = this;
+	ExecuteQueuedCommands();
+	_searchIndex.Sync();
 
 	auto window = ImGui::GetCurrentWindow();
 	_windowPos = window->Pos;
 	_windowSize = window->Size;
 
+	if (_hasPendingFocus && _windowSize.x > 0)
+		FocusPosition(_pendingFocusPosition);
+
 	_drawList = ImGui::GetWindowDrawList();
 	_drawList->ChannelsSplit(3);
 
@@ -81,12 +116,35 @@ void NodesGraph::Deserialize(std::string data)
 
 	try {
 		std::map<std::string, NodeSlot*> slots;
+		_encodedNodes.Clear();
+		_encodedConnections.Clear();
+		_contentHashVersion = UINT64_MAX;
 
 		json jsonGraph = json::parse(data);
-		json jsonArrayNodes = jsonGraph["nodes"];
+		_savedHeader.clear();
+		if (jsonGraph.contains("header"))
+		{
+			_id = jsonGraph["header"].value("id", _id);
+			_savedHeader = jsonGraph["header"].dump();
+		}
+
+		const json& jsonArrayNodes = jsonGraph["nodes"];
+		const json& jsonArrayConnections = jsonGraph["connections"];
+		_nodes.reserve(jsonArrayNodes.size());
+
+		// The lines of a saved graph are the encoded records, so the nodes
+		// don't have to be encoded again for the first snapshot.
+		std::vector<std::string_view> nodeLines;
+		std::vector<std::string_view> connectionLines;
+		auto hasLines = GraphSnapshot::SplitRecords(data, nodeLines, connectionLines) &&
+			nodeLines.size() == jsonArrayNodes.size() && connectionLines.size() == jsonArrayConnections.size();
+
+		std::vector<EncodedRecord> encodedNodes;
+		std::vector<EncodedRecord> encodedConnections;
 
-		for (const auto& jsonNode : jsonArrayNodes)
+		for (size_t i = 0; i < jsonArrayNodes.size(); i++)
 		{
+			const auto& jsonNode = jsonArrayNodes[i];
 			std::string id = jsonNode["id"];
 			std::string type = jsonNode["type"];
 
@@ -97,10 +155,15 @@ void NodesGraph::Deserialize(std::string data)
 			node->FromJson(jsonNode);
 			_nodes[id] = node;
 
+			if (hasLines)
+				encodedNodes.push_back({ id, std::string(nodeLines[i]), 0 });
+			else
+				_encodedNodes.Set(id, node);
+
 			for (auto slot : node->GetSlots())
 				slots[slot->GetId()] = slot;
 
-			auto groupNode = dynamic_cast<_GroupNode*>(node);
+			auto groupNode = node->AsGroup();
 			if (groupNode != nullptr)
 			{
 				for (const auto& child : groupNode->GetNodes())
@@ -111,9 +174,10 @@ void NodesGraph::Deserialize(std::string data)
 			}
 		}
 
-		json jsonArrayConnections = jsonGraph["connections"];
-		for (const auto& jsonConnection : jsonArrayConnections)
+		_connections.reserve(jsonArrayConnections.size());
+		for (size_t i = 0; i < jsonArrayConnections.size(); i++)
 		{
+			const auto& jsonConnection = jsonArrayConnections[i];
 			std::string idFrom = jsonConnection["from"];
 			std::string idTo = jsonConnection["to"];
 
@@ -129,9 +193,27 @@ void NodesGraph::Deserialize(std::string data)
 				connection->GetTo()->AddConnectionTo();
 
 				_connections[connection->GetId()] = connection;
+
+				if (hasLines)
+					encodedConnections.push_back({ connection->GetId(), std::string(connectionLines[i]), 0 });
+				else
+					_encodedConnections.Set(connection->GetId(), connection);
 			}
 		}
 
+		if (hasLines)
+		{
+			_encodedNodes.Reset(std::move(encodedNodes));
+			_encodedConnections.Reset(std::move(encodedConnections));
+		}
+
+		// Of the records as loaded, also for files saved without a hash. Only
+		// encodes the nodes if the lines couldn't be used.
+		_savedContentHash = GetContentHash();
+		_savedChangeVersion = _changeVersion;
+
+		RebuildAnalyses();
+
 		jsonGraph.at("scale").get_to(_scaleIndex);
 		jsonGraph.at("offset_x").get_to(_offset.x);
 		jsonGraph.at("offset_y").get_to(_offset.y);
@@ -140,6 +222,9 @@ void NodesGraph::Deserialize(std::string data)
 
 		_targetScale = _zoomLevels[_scaleIndex];
 		_scale = _targetScale;
+
+		_savedScaleIndex = _scaleIndex;
+		_savedOffset = _offset;
 	}
 	catch (const json::parse_error& e) {
 	}
@@ -149,47 +234,156 @@ void NodesGraph::Deserialize(std::string data)
 
 std::string NodesGraph::Serialize()
 {
-	using json = nlohmann::json;
-	json jsonGraph;
-	json jsonArrayNodes = json::array();
+	SyncSubgraph();
 
-	for (const auto& [_, node] : _nodes)
+	auto snapshot = TakeSnapshot();
+	MarkSaved();
+
+	_savedHeader = snapshot.GetHeader();
+	_savedScaleIndex = _scaleIndex;
+	_savedOffset = _offset;
+
+	return snapshot.Serialize();
+}
+
+void NodesGraph::MarkSaved()
+{
+	_savedContentHash = GetContentHash();
+	_savedChangeVersion = _changeVersion;
+	_commands.Seal();
+	_journal.Checkpoint();
+}
+
+bool NodesGraph::IsSerializedUnchanged()
+{
+	if (HasUnsavedChanges() || _scaleIndex != _savedScaleIndex || _offset.x != _savedOffset.x || _offset.y != _savedOffset.y)
+		return false;
+
+	return TakeSnapshot().GetHeader() == _savedHeader;
+}
+
+uint64_t NodesGraph::GetContentHash()
+{
+	// Picks up changes made outside of Execute/Undo/Redo.
+	FlushChanges();
+
+	if (_contentHashVersion != _changeVersion)
 	{
-		json jsonNode;
-		node->ToJson(jsonNode);
-		jsonArrayNodes.push_back(jsonNode);
+		_contentHash = GraphSnapshot::HashChunks(PublishNodes(), PublishConnections());
+		_contentHashVersion = _changeVersion;
 	}
 
-	jsonGraph["nodes"] = jsonArrayNodes;
+	return _contentHash;
+}
+
+std::string NodesGraph::EncodeNode(Node* node)
+{
+	nlohmann::json jsonNode;
+	node->ToJson(jsonNode);
+	return jsonNode.dump();
+}
+
+std::string NodesGraph::EncodeConnection(NodeConnection* connection)
+{
+	nlohmann::json jsonConnection;
+	connection->ToJson(jsonConnection);
+	return jsonConnection.dump();
+}
+
+const EncodedChunkArray& NodesGraph::PublishNodes()
+{
+	// Only the nodes touched since the last time are re-encoded.
+	return _encodedNodes.Publish(EncodeNode);
+}
+
+const EncodedChunkArray& NodesGraph::PublishConnections()
+{
+	return _encodedConnections.Publish(EncodeConnection);
+}
+
+GraphSnapshot NodesGraph::TakeSnapshot()
+{
+	using json = nlohmann::json;
 
-	json jsonArrayConnections = json::array();
+	auto contentHash = GetContentHash();
+	auto& nodes = PublishNodes();
+	auto& connections = PublishConnections();
 
-	for (const auto& [_, value] : _connections)
+	// Read by GraphProject without loading the graph.
+	std::vector<NodeKey> keys;
+	_keyIndex.GetExternalKeys(keys);
+
+	json jsonKeys = json::array();
+	for (const auto& key : keys)
+		jsonKeys.push_back({ key.name, key.value, key.role == NodeKey::Definition ? 0 : 1 });
+
+	json jsonHeader;
+	jsonHeader["id"] = _id;
+	jsonHeader["node_count"] = _nodes.size();
+	jsonHeader["connection_count"] = _connections.size();
+	jsonHeader["keys"] = jsonKeys;
+	jsonHeader["hash"] = FormatHash(contentHash);
+
+	// As of the last time the nodes were drawn.
+	size_t invalidCount = 0;
+	for (const auto& [_, node] : _nodes)
 	{
-		json jsonConnection;
-		value->ToJson(jsonConnection);
-		jsonArrayConnections.push_back(jsonConnection);
+		if (!node->IsValid())
+			invalidCount++;
 	}
+	jsonHeader["invalid_count"] = invalidCount;
 
-	jsonGraph["connections"] = jsonArrayConnections;
-	jsonGraph["scale"] = _scaleIndex;
-	jsonGraph["offset_x"] = _offset.x / NodesGraphSettings::GetDpiScale();
-	jsonGraph["offset_y"] = _offset.y / NodesGraphSettings::GetDpiScale();
+	auto dpiScale = NodesGraphSettings::GetDpiScale();
+	return GraphSnapshot(nodes, connections, _scaleIndex, _offset.x / dpiScale, _offset.y / dpiScale, _changeVersion, jsonHeader.dump());
+}
+
+GraphSnapshot NodesGraph::TakeRecordsSnapshot()
+{
+	FlushChanges();
 
-	// TODO: This shouldn't be here.
-	_savedCommandIndex = _commands.CommandIndex();
+	auto& nodes = PublishNodes();
+	auto& connections = PublishConnections();
 
-	return jsonGraph.dump();
+	auto dpiScale = NodesGraphSettings::GetDpiScale();
+	return GraphSnapshot(nodes, connections, _scaleIndex, _offset.x / dpiScale, _offset.y / dpiScale, _changeVersion);
 }
 
 void NodesGraph::Execute(_Command* command)
 {
 	_commands.Execute(command);
+	FlushChanges();
+	_commands.Trim(NodesGraphSettings::HistoryMaxBytes(), NodesGraphSettings::HistoryMaxCommands());
+}
+
+void NodesGraph::ExecuteQueuedCommands()
+{
+	auto command = _commandQueue.Pop();
+	if (command == nullptr) return;
+
+	auto next = _commandQueue.Pop();
+	if (next == nullptr) {
+		Execute(command);
+		return;
+	}
+
+	// Everything posted since the last frame is undone as one step.
+	auto cluster = new CommandCluster("External Changes");
+	cluster->Add(command);
+
+	size_t count = 1;
+	while (next != nullptr) {
+		cluster->Add(next);
+		next = ++count < _maxQueuedCommandsPerFrame ? _commandQueue.Pop() : nullptr;
+	}
+
+	Execute(cluster);
 }
 
 void NodesGraph::Undo()
 {
+	LeaveSubgraph();
 	_commands.Undo();
+	FlushChanges();
 }
 
 std::vector<_Command*>& NodesGraph::GetUndoStack()
@@ -199,7 +393,9 @@ std::vector<_Command*>& NodesGraph::GetUndoStack()
 
 void NodesGraph::Redo()
 {
+	LeaveSubgraph();
 	_commands.Redo();
+	FlushChanges();
 }
 
 std::vector<_Command*>& NodesGraph::GetRedoStack()
@@ -207,14 +403,35 @@ std::vector<_Command*>& NodesGraph::GetRedoStack()
 	return _commands.GetRedoStack();
 }
 
-bool NodesGraph::HasUnsavedChanges() const
+size_t NodesGraph::GetHistoryMemoryUsage() const
+{
+	return _commands.GetMemoryUsage();
+}
+
+bool NodesGraph::HasUnsavedChanges()
+{
+	if (_enteredSubgraph != nullptr && _enteredSubgraph->GetLoadedGraph()->HasUnsavedChanges())
+		return true;
+
+	if (_changeVersion == _savedChangeVersion)
+		return false;
+
+	// Also clean after undoing back to the saved state, or making the same edit again.
+	return GetContentHash() != _savedContentHash;
+}
+
+void NodesGraph::BringToFront(Node* node)
 {
-	return _savedCommandIndex != _commands.CommandIndex();
+	if (node->GetLayout() == &_layout)
+		_layout.BringToFront(node->GetLayoutIndex());
 }
 
 void NodesGraph::FocusPosition(const ImVec2& position)
 {
 	_offset = (_windowSize / 2) - position * _scale;
+
+	_hasPendingFocus = _windowSize.x <= 0;
+	_pendingFocusPosition = position;
 }
 
 void NodesGraph::FocusOnNode(Node* node)
@@ -222,6 +439,333 @@ void NodesGraph::FocusOnNode(Node* node)
 	FocusPosition(node->GetPosition() + node->GetSize() / 2);
 }
 
+void NodesGraph::AddNode(Node* node)
+{
+	_nodes.emplace(node->GetId(), node);
+	_layout.Add(node);
+	_reachability.AddNode(node);
+	_keyIndex.Add(node);
+	_searchIndex.Add(node);
+
+	if (node->IsGroup())
+		SetRootNode(node->AsGroup(), node);
+
+	_changedNodes[node->GetId()] = node;
+}
+
+void NodesGraph::RemoveNode(Node* node)
+{
+	_nodes.erase(node->GetId());
+	_layout.Remove(node);
+	_selectedNodes.erase(node);
+	node->SetIsSelected(false);
+
+	if (node->IsGroup()) {
+		DeselectChildNodes(node->AsGroup());
+		ClearRootNode(node->AsGroup());
+	}
+
+	_reachability.RemoveNode(node);
+	_keyIndex.Remove(node);
+	_searchIndex.Remove(node);
+
+	_changedNodes[node->GetId()] = nullptr;
+}
+
+void NodesGraph::InsertChildNode(_GroupNode* parent, Node* node, size_t index)
+{
+	auto& children = parent->GetNodes();
+	children.insert(children.begin() + index, node);
+	_reachability.AddChildNode(parent, node);
+	_keyIndex.Add(node);
+	_searchIndex.Add(node);
+
+	auto root = FindRootNode(parent);
+	_rootNodes[node] = root;
+	if (node->IsGroup())
+		SetRootNode(node->AsGroup(), root);
+
+	MarkNodeChanged(parent);
+}
+
+size_t NodesGraph::RemoveChildNode(_GroupNode* parent, Node* node)
+{
+	auto& children = parent->GetNodes();
+	auto it = std::find(children.begin(), children.end(), node);
+	auto index = std::distance(children.begin(), it);
+	children.erase(it);
+
+	_selectedChildNodes.erase(node);
+	node->SetIsSelected(false);
+
+	_reachability.RemoveChildNode(parent, node);
+	_keyIndex.Remove(node);
+	_searchIndex.Remove(node);
+
+	_rootNodes.erase(node);
+	if (node->IsGroup())
+		ClearRootNode(node->AsGroup());
+
+	MarkNodeChanged(parent);
+	return index;
+}
+
+void NodesGraph::AddConnection(NodeConnection* connection)
+{
+	_connections.emplace(connection->GetId(), connection);
+	connection->GetFrom()->AddConnectionFrom();
+	connection->GetTo()->AddConnectionTo();
+
+	_reachability.AddConnection(connection);
+	_slotConnections.Add(connection);
+	_changedConnections[connection->GetId()] = connection;
+}
+
+void NodesGraph::RemoveConnection(NodeConnection* connection)
+{
+	_connections.erase(connection->GetId());
+	connection->GetFrom()->RemoveConnectionFrom();
+	connection->GetTo()->RemoveConnectionTo();
+
+	_reachability.RemoveConnection(connection);
+	_slotConnections.Remove(connection);
+	_changedConnections[connection->GetId()] = nullptr;
+}
+
+void NodesGraph::AddNodes(const std::vector<Node*>& nodes, const std::vector<NodeConnection*>& connections)
+{
+	// Rebuilding costs as much as the whole graph, small batches are cheaper to apply one by one.
+	if ((nodes.size() + connections.size()) * 2 < _nodes.size() + _connections.size()) {
+		for (auto node : nodes)
+			AddNode(node);
+
+		for (auto connection : connections)
+			AddConnection(connection);
+
+		return;
+	}
+
+	_nodes.reserve(_nodes.size() + nodes.size());
+	_connections.reserve(_connections.size() + connections.size());
+	_changedNodes.reserve(_changedNodes.size() + nodes.size());
+	_changedConnections.reserve(_changedConnections.size() + connections.size());
+
+	for (auto node : nodes) {
+		_nodes.emplace(node->GetId(), node);
+		_changedNodes[node->GetId()] = node;
+	}
+
+	for (auto connection : connections) {
+		_connections.emplace(connection->GetId(), connection);
+		connection->GetFrom()->AddConnectionFrom();
+		connection->GetTo()->AddConnectionTo();
+
+		_changedConnections[connection->GetId()] = connection;
+	}
+
+	RebuildAnalyses();
+}
+
+void NodesGraph::RemoveNodes(const std::vector<Node*>& nodes, const std::vector<NodeConnection*>& connections)
+{
+	if ((nodes.size() + connections.size()) * 2 < _nodes.size() + _connections.size()) {
+		for (auto connection : connections)
+			RemoveConnection(connection);
+
+		for (auto node : nodes)
+			RemoveNode(node);
+
+		return;
+	}
+
+	_changedNodes.reserve(_changedNodes.size() + nodes.size());
+	_changedConnections.reserve(_changedConnections.size() + connections.size());
+
+	for (auto connection : connections) {
+		_connections.erase(connection->GetId());
+		connection->GetFrom()->RemoveConnectionFrom();
+		connection->GetTo()->RemoveConnectionTo();
+
+		_changedConnections[connection->GetId()] = nullptr;
+	}
+
+	for (auto node : nodes) {
+		_nodes.erase(node->GetId());
+		_selectedNodes.erase(node);
+		node->SetIsSelected(false);
+
+		if (node->IsGroup()) {
+			DeselectChildNodes(node->AsGroup());
+			ClearRootNode(node->AsGroup());
+		}
+
+		_changedNodes[node->GetId()] = nullptr;
+	}
+
+	RebuildAnalyses();
+}
+
+void NodesGraph::SetConnectionSlots(NodeConnection* connection, NodeSlot* from, NodeSlot* to)
+{
+	_reachability.RemoveConnection(connection);
+	_slotConnections.Remove(connection);
+
+	if (connection->GetFrom() != from) {
+		connection->GetFrom()->RemoveConnectionFrom();
+		connection->SetFrom(from);
+		from->AddConnectionFrom();
+	}
+
+	if (connection->GetTo() != to) {
+		connection->GetTo()->RemoveConnectionTo();
+		connection->SetTo(to);
+		to->AddConnectionTo();
+	}
+
+	_reachability.AddConnection(connection);
+	_slotConnections.Add(connection);
+	_changedConnections[connection->GetId()] = connection;
+}
+
+void NodesGraph::OnNodeChanged(Node* node)
+{
+	_keyIndex.Update(node);
+	_searchIndex.Update(node);
+
+	MarkNodeChanged(node);
+}
+
+void NodesGraph::OnNodeMoved(Node* node)
+{
+	MarkNodeChanged(node);
+}
+
+void NodesGraph::OnConnectionChanged(NodeConnection* connection)
+{
+	if (_connections.contains(connection->GetId()))
+		_changedConnections[connection->GetId()] = connection;
+}
+
+Node* NodesGraph::FindRootNode(Node* node)
+{
+	auto it = _nodes.find(node->GetId());
+	if (it != _nodes.end() && it->second == node)
+		return node;
+
+	auto root = _rootNodes.find(node);
+	return root != _rootNodes.end() ? root->second : nullptr;
+}
+
+void NodesGraph::SetRootNode(_GroupNode* group, Node* root)
+{
+	for (auto child : group->GetNodes()) {
+		_rootNodes[child] = root;
+		if (child->IsGroup())
+			SetRootNode(child->AsGroup(), root);
+	}
+}
+
+void NodesGraph::ClearRootNode(_GroupNode* group)
+{
+	for (auto child : group->GetNodes()) {
+		_rootNodes.erase(child);
+		if (child->IsGroup())
+			ClearRootNode(child->AsGroup());
+	}
+}
+
+void NodesGraph::MarkNodeChanged(Node* node)
+{
+	auto root = FindRootNode(node);
+	if (root != nullptr)
+		_changedNodes[root->GetId()] = root;
+}
+
+void NodesGraph::FlushChanges()
+{
+	if (!_changedNodes.empty() || !_changedConnections.empty())
+		_changeVersion++;
+
+	if (_journal.IsOpen())
+	{
+		for (const auto& [id, node] : _changedNodes)
+		{
+			if (node == nullptr) {
+				_journal.AppendNodeRemoved(id);
+				continue;
+			}
+
+			nlohmann::json jsonNode;
+			node->ToJson(jsonNode);
+			_journal.AppendNode(id, std::move(jsonNode));
+		}
+
+		for (const auto& [id, connection] : _changedConnections)
+		{
+			if (connection == nullptr) {
+				_journal.AppendConnectionRemoved(id);
+				continue;
+			}
+
+			nlohmann::json jsonConnection;
+			connection->ToJson(jsonConnection);
+			_journal.AppendConnection(id, std::move(jsonConnection));
+		}
+	}
+
+	for (const auto& [id, node] : _changedNodes) {
+		if (node != nullptr) _encodedNodes.Set(id, node);
+		else _encodedNodes.Remove(id);
+	}
+
+	for (const auto& [id, connection] : _changedConnections) {
+		if (connection != nullptr) _encodedConnections.Set(id, connection);
+		else _encodedConnections.Remove(id);
+	}
+
+	_changedNodes.clear();
+	_changedConnections.clear();
+}
+
+void NodesGraph::RebuildAnalyses()
+{
+	_reachability.Rebuild(_nodes, _connections);
+	_slotConnections.Rebuild(_connections);
+	_keyIndex.Rebuild(_nodes);
+	_layout.Rebuild(_nodes);
+	_searchIndex.Rebuild(_nodes);
+
+	_rootNodes.clear();
+	for (const auto& [_, node] : _nodes) {
+		if (node->IsGroup())
+			SetRootNode(node->AsGroup(), node);
+	}
+}
+
+bool NodesGraph::OpenJournal(const std::string& path)
+{
+	return _journal.Open(path);
+}
+
+void NodesGraph::CloseJournal(bool discard)
+{
+	_journal.Close(discard);
+}
+
+void NodesGraph::Recover(const std::string& data, const std::string& journalData)
+{
+	try {
+		Deserialize(UndoJournal::Replay(data, journalData));
+	}
+	catch (const std::exception& e) {
+		Deserialize(data);
+	}
+
+	// The recovered changes are not in the saved file yet.
+	_savedContentHash = 0;
+	_savedChangeVersion = UINT64_MAX;
+}
+
 void NodesGraph::DrawBackground() const
 {
 	if (_scale < .4) return;
@@ -321,40 +865,40 @@ void NodesGraph::DrawNodes()
 	_hoveredChildNode = nullptr;
 	_hoveredChildNodeParent = nullptr;
 
-	_hasOffscreenNodesLeft = false;
-	_hasOffscreenNodesRight = false;
-	_hasOffscreenNodesTop = false;
-	_hasOffscreenNodesBottom = false;
+	// Culling and the offscreen indicators only need the bounds, scan them up front.
+	auto viewMin = ScreenToCanvas(_windowPos);
+	auto viewMax = ScreenToCanvas(_windowPos + _windowSize);
+	auto offscreenSides = _layout.Cull(viewMin, viewMax, _offscreenSides);
 
-	for (const auto& [_, node] : _nodes)
+	_hasOffscreenNodesLeft = offscreenSides & NodeLayout::Sides_Left;
+	_hasOffscreenNodesRight = offscreenSides & NodeLayout::Sides_Right;
+	_hasOffscreenNodesTop = offscreenSides & NodeLayout::Sides_Top;
+	_hasOffscreenNodesBottom = offscreenSides & NodeLayout::Sides_Bottom;
+
+	// Back to front, so the top-most node is also the one ImGui reports as hovered.
+	// Nodes brought to the front during the loop are appended past `orderCount`.
+	_layout.CompactOrder();
+	auto& order = _layout.GetOrder();
+	auto orderCount = order.size();
+
+	for (size_t orderIndex = 0; orderIndex < orderCount; orderIndex++)
 	{
+		auto nodeIndex = order[orderIndex];
+		if (nodeIndex < 0) continue;
+
+		auto node = _layout.GetNode(nodeIndex);
 		auto nodePosition = node->GetPosition();
 		auto nodeSize = node->GetSize();
-		auto shouldClip = false;
-
-		auto nodeMin = CanvasToScreen(ImVec2(nodePosition.x, nodePosition.y));
-		auto nodeMax = CanvasToScreen(ImVec2(nodePosition.x + nodeSize.x, nodePosition.y + nodeSize.y));
-
-		if (nodeMax.x < _windowPos.x) {
-			_hasOffscreenNodesLeft = true;
-			shouldClip = true;
-		}
-		if (nodeMin.x > _windowPos.x + _windowSize.x) {
-			_hasOffscreenNodesRight = true;
-			shouldClip = true;
-		}
-		if (nodeMax.y < _windowPos.y) {
-			_hasOffscreenNodesTop = true;
-			shouldClip = true;
-		}
-		if (nodeMin.y > _windowPos.y + _windowSize.y) {
-			_hasOffscreenNodesBottom = true;
-			shouldClip = true;
-		}
+		auto shouldClip = _offscreenSides[nodeIndex] != 0;
 
 		auto clipDetails = (nodeSize.x != 0 && shouldClip) || (_scaleIndex <= _scaleIndexClipDetails);
 
+		_currentNode = node;
 		node->Draw(_drawList, clipDetails);
+		_currentNode = nullptr;
+
+		if (NodesGraphSettings::HighlightUnreachableNodes() && _reachability.IsDead(node))
+			DrawUnreachableOutline(node);
 
 		if (!node->IsValid() && node->IsValidationCircleHovered())
 			_validationMessage = node->GetValidationMessage();
@@ -373,7 +917,7 @@ void NodesGraph::DrawNodes()
 				_hoveredSlot = slot;
 		}
 
-		auto groupNode = dynamic_cast<_GroupNode*>(node);
+		auto groupNode = node->AsGroup();
 		if (groupNode != nullptr)
 		{
 			int childYPos = 0;
@@ -383,7 +927,12 @@ void NodesGraph::DrawNodes()
 			{
 				float offsetY = (groupNode->GetSize() - groupNode->GetDummySize()).y - 26_dpi;
 				childNode->SetPosition(groupNode->GetPosition() + ImVec2(8_dpi, offsetY + childYPos));
+				_currentNode = childNode;
 				childNode->Draw(_drawList, clipDetails);
+				_currentNode = nullptr;
+
+				if (NodesGraphSettings::HighlightUnreachableNodes() && _reachability.IsDead(childNode))
+					DrawUnreachableOutline(childNode);
 
 				if (!childNode->IsValid() && childNode->IsValidationCircleHovered())
 					_validationMessage = childNode->GetValidationMessage();
@@ -401,6 +950,9 @@ void NodesGraph::DrawNodes()
 					_hoveredChildNodeParent = groupNode;
 				}
 
+				if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && childNode->IsHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left))
+					SetChildNodeSelected(groupNode, childNode, !childNode->IsSelected());
+
 				for (auto& slot : childNode->GetSlots())
 				{
 					auto isEnabled = true;
@@ -422,48 +974,16 @@ void NodesGraph::DrawNodes()
 			auto createdNode = groupNode->GetCreatedNode();
 			if (createdNode) {
 				createdNode->PreDraw(_drawList);
-				Execute(new CreateChildNodeCommand(createdNode, &groupNode->GetNodes()));
+				Execute(new CreateChildNodeCommand(createdNode, groupNode, this));
 			}
 		}
 
 		if (node->IsHovered())
 			_hoveredNode = node;
 
-		if (_isDrawingSelection)
-		{
-			// TODO: Extract as a function?
-			ImVec2 selectionRectMin;
-			ImVec2 selectionRectMax;
-
-			auto mousePosition = ImGui::GetMousePos();
-
-			selectionRectMin.x = min(_drawingSelectionFrom.x, mousePosition.x);
-			selectionRectMin.y = min(_drawingSelectionFrom.y, mousePosition.y);
-			selectionRectMax.x = max(_drawingSelectionFrom.x, mousePosition.x);
-			selectionRectMax.y = max(_drawingSelectionFrom.y, mousePosition.y);
-
-			auto nodePosition = node->GetPosition();
-			auto nodeSize = node->GetSize();
-			auto nodeRect = ImRect{ nodePosition.x, nodePosition.y, nodePosition.x + nodeSize.x, nodePosition.y + nodeSize.y };
-			auto selectionRect = ImRect{ selectionRectMin.x, selectionRectMin.y, selectionRectMax.x, selectionRectMax.y };
-			auto isOverlappedBySelection = selectionRect.Overlaps(nodeRect);
-
-			if (isOverlappedBySelection)
-			{
-				if (_selectedNodes.find(node) == _selectedNodes.end())
-					_selectedNodes.insert(node);
-			}
-			else if (!ImGui::IsKeyDown(ImGuiKey_LeftCtrl))
-			{
-				if (_selectedNodes.find(node) != _selectedNodes.end())
-					_selectedNodes.erase(node);
-			}
+		if (node->IsHovered() && (ImGui::IsMouseClicked(ImGuiMouseButton_Left) || ImGui::IsMouseClicked(ImGuiMouseButton_Right)))
+			BringToFront(node);
 
-			if (isOverlappedBySelection)
-				node->SetIsSelected(true);
-			else if (!ImGui::IsKeyDown(ImGuiKey_LeftCtrl))
-				node->SetIsSelected(false);
-		}
 		if (!_isDraggingNodes && node->IsPressed() && ImGui::IsMouseDragging(ImGuiMouseButton_Left))
 		{
 			if (!node->IsSelected())
@@ -481,31 +1001,20 @@ void NodesGraph::DrawNodes()
 
 		if (ImGui::IsKeyDown(ImGuiKey_LeftCtrl) && node->IsHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left)) {
 
-			if (node->IsSelected()) {
-				if (_selectedNodes.find(node) != _selectedNodes.end())
-					_selectedNodes.erase(node);
-
-				node->SetIsSelected(false);
-			}
-			else {
-				if (_selectedNodes.find(node) == _selectedNodes.end())
-					_selectedNodes.insert(node);
-
-				node->SetIsSelected(true);
-			}
+			SetNodeSelected(node, !node->IsSelected());
 		}
 	}
 
+	if (_isDrawingSelection)
+		UpdateRectangleSelection();
+
 	// TODO: Move out
 	if (_hoveredSlot) {
 		if (_hoveredSlot->IsPressed()) {
 			_isDrawingConnection = true;
 			_drawingConnectionFrom = _hoveredSlot;
 
-			for (const auto& selectedNode : _selectedNodes)
-				selectedNode->SetIsSelected(false);
-
-			_selectedNodes.clear();
+			ClearSelection();
 			ImGui::ClearActiveID();
 		}
 	}
@@ -538,30 +1047,773 @@ void NodesGraph::DrawNodes()
 		if (ImGui::IsMouseReleased(ImGuiMouseButton_Left))
 		{
 			if (_draggedChildNodeIndex != newPlaceIndex)
-				Execute(new MoveChildNodeCommand(_draggedChildNode, _draggedChildNodeParent->GetNodes(), _draggedChildNodeIndex, newPlaceIndex));
+				Execute(new MoveChildNodeCommand(_draggedChildNode, _draggedChildNodeParent->GetNodes(), _draggedChildNodeIndex, newPlaceIndex, this));
 
 			_draggedChildNode = nullptr;
 		}
 	}
 }
 
-void NodesGraph::HandleNodesDragging()
+void NodesGraph::BeginRectangleSelection()
 {
-	if (_isDraggingNodes)
-	{
-		if (_draggedNode != nullptr) {
-			_draggedNodePos += _io.MouseDelta;
-			auto pos = _draggedNodePos;
+	_isDrawingSelection = true;
+	_drawingSelectionFrom = ImGui::GetMousePos();
+	_hasSelectionRect = false;
+	_isSelectingChildNodes = ImGui::IsKeyDown(ImGuiKey_LeftShift);
 
-			if (NodesGraphSettings::NodeSnappingEnabled() && !ImGui::IsKeyDown(ImGuiKey_LeftAlt)) {
-				auto snap = NodesGraphSettings::NodeSnappingValue();
-				pos = ImVec2(((int)(_draggedNodePos.x + 2) / snap) * snap, ((int)(_draggedNodePos.y + 2) / snap) * snap);
-			}
+	if (!ImGui::IsKeyDown(ImGuiKey_LeftCtrl))
+		ClearSelection();
+}
 
-			_draggedNode->SetPosition(pos);
-		}
-		else {
-			for (auto& node : _selectedNodes)
+void NodesGraph::UpdateRectangleSelection()
+{
+	auto mousePosition = ImGui::GetMousePos();
+
+	ImVec2 selectionRectMin;
+	ImVec2 selectionRectMax;
+
+	selectionRectMin.x = min(_drawingSelectionFrom.x, mousePosition.x);
+	selectionRectMin.y = min(_drawingSelectionFrom.y, mousePosition.y);
+	selectionRectMax.x = max(_drawingSelectionFrom.x, mousePosition.x);
+	selectionRectMax.y = max(_drawingSelectionFrom.y, mousePosition.y);
+
+	// Only nodes overlapping the previous or the current rectangle can change state.
+	auto queryMin = selectionRectMin;
+	auto queryMax = selectionRectMax;
+
+	if (_hasSelectionRect) {
+		queryMin.x = min(queryMin.x, _selectionRectMin.x);
+		queryMin.y = min(queryMin.y, _selectionRectMin.y);
+		queryMax.x = max(queryMax.x, _selectionRectMax.x);
+		queryMax.y = max(queryMax.y, _selectionRectMax.y);
+	}
+
+	_hasSelectionRect = true;
+	_selectionRectMin = selectionRectMin;
+	_selectionRectMax = selectionRectMax;
+
+	_layout.Query(queryMin, queryMax, _selectionCandidates);
+
+	auto selectionRect = ImRect(selectionRectMin, selectionRectMax);
+	auto keepSelection = ImGui::IsKeyDown(ImGuiKey_LeftCtrl);
+
+	for (auto nodeIndex : _selectionCandidates)
+	{
+		auto node = _layout.GetNode(nodeIndex);
+
+		if (_isSelectingChildNodes)
+		{
+			auto groupNode = node->AsGroup();
+			if (groupNode == nullptr) continue;
+
+			for (auto childNode : groupNode->GetNodes())
+			{
+				auto isOverlapped = selectionRect.Overlaps(ImRect(childNode->GetPosition(), childNode->GetPosition() + childNode->GetSize()));
+				if (isOverlapped != childNode->IsSelected() && (isOverlapped || !keepSelection))
+					SetChildNodeSelected(groupNode, childNode, isOverlapped);
+			}
+
+			continue;
+		}
+
+		auto isOverlapped = _layout.Overlaps(nodeIndex, selectionRectMin, selectionRectMax);
+		if (isOverlapped != _layout.IsSelected(nodeIndex) && (isOverlapped || !keepSelection))
+			SetNodeSelected(node, isOverlapped);
+	}
+}
+
+void NodesGraph::SetNodeSelected(Node* node, bool value)
+{
+	if (value)
+		_selectedNodes.insert(node);
+	else
+		_selectedNodes.erase(node);
+
+	node->SetIsSelected(value);
+}
+
+void NodesGraph::SetChildNodeSelected(_GroupNode* parent, Node* node, bool value)
+{
+	if (value)
+		_selectedChildNodes[node] = parent;
+	else
+		_selectedChildNodes.erase(node);
+
+	node->SetIsSelected(value);
+}
+
+void NodesGraph::DeselectChildNodes(_GroupNode* parent)
+{
+	for (auto childNode : parent->GetNodes())
+	{
+		if (_selectedChildNodes.erase(childNode) != 0)
+			childNode->SetIsSelected(false);
+	}
+}
+
+void NodesGraph::ClearSelection()
+{
+	for (auto node : _selectedNodes)
+		node->SetIsSelected(false);
+	_selectedNodes.clear();
+
+	for (auto& [childNode, _] : _selectedChildNodes)
+		childNode->SetIsSelected(false);
+	_selectedChildNodes.clear();
+}
+
+std::vector<Node*> NodesGraph::GetSelection() const
+{
+	return std::vector<Node*>(_selectedNodes.begin(), _selectedNodes.end());
+}
+
+void NodesGraph::MoveNodesTo(const std::vector<Node*>& nodes, const std::vector<ImVec2>& positions, const char* label)
+{
+	std::vector<Node*> movedNodes;
+	std::vector<ImVec2> deltas;
+	movedNodes.reserve(nodes.size());
+	deltas.reserve(nodes.size());
+
+	for (size_t i = 0; i < nodes.size(); i++) {
+		auto delta = positions[i] - nodes[i]->GetRecordedPosition();
+		if (delta.x == 0 && delta.y == 0) continue;
+
+		movedNodes.push_back(nodes[i]);
+		deltas.push_back(delta);
+	}
+
+	if (!movedNodes.empty())
+		Execute(new MoveNodesCommand(std::move(movedNodes), std::move(deltas), this, label));
+}
+
+void NodesGraph::AlignSelection(NodeAlignment alignment)
+{
+	auto nodes = GetSelection();
+	if (nodes.size() < 2) return;
+
+	ImRect bounds(nodes[0]->GetPosition(), nodes[0]->GetPosition() + nodes[0]->GetSize());
+	for (auto node : nodes)
+		bounds.Add(ImRect(node->GetPosition(), node->GetPosition() + node->GetSize()));
+
+	auto center = bounds.GetCenter();
+
+	std::vector<ImVec2> positions;
+	positions.reserve(nodes.size());
+
+	for (auto node : nodes) {
+		auto position = node->GetPosition();
+		auto size = node->GetSize();
+
+		switch (alignment) {
+		case NodeAlignment_Left: position.x = bounds.Min.x; break;
+		case NodeAlignment_Right: position.x = bounds.Max.x - size.x; break;
+		case NodeAlignment_Top: position.y = bounds.Min.y; break;
+		case NodeAlignment_Bottom: position.y = bounds.Max.y - size.y; break;
+		case NodeAlignment_CenterX: position.x = center.x - size.x / 2; break;
+		case NodeAlignment_CenterY: position.y = center.y - size.y / 2; break;
+		}
+
+		positions.push_back(position);
+	}
+
+	MoveNodesTo(nodes, positions, "Align Nodes");
+}
+
+void NodesGraph::DistributeSelection(bool horizontally)
+{
+	auto nodes = GetSelection();
+	if (nodes.size() < 3) return;
+
+	auto axis = horizontally ? 0 : 1;
+	auto getMin = [axis](Node* node) { return axis == 0 ? node->GetPosition().x : node->GetPosition().y; };
+	auto getSize = [axis](Node* node) { return axis == 0 ? node->GetSize().x : node->GetSize().y; };
+
+	std::sort(nodes.begin(), nodes.end(), [&](Node* a, Node* b) {
+		return getMin(a) + getSize(a) / 2 < getMin(b) + getSize(b) / 2;
+		});
+
+	float start = getMin(nodes.front());
+	float end = start;
+	float totalSize = 0;
+	for (auto node : nodes) {
+		end = max(end, getMin(node) + getSize(node));
+		totalSize += getSize(node);
+	}
+
+	// Negative when the nodes don't fit, they overlap evenly then.
+	auto gap = (end - start - totalSize) / (nodes.size() - 1);
+
+	std::vector<ImVec2> positions;
+	positions.reserve(nodes.size());
+
+	auto offset = start;
+	for (auto node : nodes) {
+		auto position = node->GetPosition();
+		(axis == 0 ? position.x : position.y) = offset;
+		positions.push_back(position);
+
+		offset += getSize(node) + gap;
+	}
+
+	MoveNodesTo(nodes, positions, "Distribute Nodes");
+}
+
+void NodesGraph::PackSelection()
+{
+	auto nodes = GetSelection();
+	if (nodes.size() < 2) return;
+
+	const float spacing = 20_dpi;
+
+	std::sort(nodes.begin(), nodes.end(), [](Node* a, Node* b) {
+		auto posA = a->GetPosition();
+		auto posB = b->GetPosition();
+		return posA.y != posB.y ? posA.y < posB.y : posA.x < posB.x;
+		});
+
+	auto origin = nodes[0]->GetPosition();
+	float area = 0;
+	float widest = 0;
+	for (auto node : nodes) {
+		auto size = node->GetSize() + ImVec2(spacing, spacing);
+		origin = ImMin(origin, node->GetPosition());
+		area += size.x * size.y;
+		widest = max(widest, size.x);
+	}
+
+	// Rows roughly as wide as the packed nodes are tall.
+	auto rowWidth = max(widest, sqrtf(area));
+
+	std::vector<ImVec2> positions;
+	positions.reserve(nodes.size());
+
+	auto cursor = origin;
+	float rowHeight = 0;
+	for (auto node : nodes) {
+		auto size = node->GetSize();
+		if (cursor.x > origin.x && cursor.x - origin.x + size.x > rowWidth) {
+			cursor = ImVec2(origin.x, cursor.y + rowHeight + spacing);
+			rowHeight = 0;
+		}
+
+		positions.push_back(cursor);
+
+		cursor.x += size.x + spacing;
+		rowHeight = max(rowHeight, size.y);
+	}
+
+	MoveNodesTo(nodes, positions, "Pack Nodes");
+}
+
+void NodesGraph::CollectSlots(const std::vector<Node*>& nodes, std::unordered_set<NodeSlot*>& slots) const
+{
+	for (auto node : nodes)
+	{
+		for (auto slot : node->GetSlots())
+			slots.insert(slot);
+
+		auto groupNode = node->AsGroup();
+		if (groupNode != nullptr)
+		{
+			for (const auto& child : groupNode->GetNodes())
+			{
+				for (auto slot : child->GetSlots())
+					slots.insert(slot);
+			}
+		}
+	}
+}
+
+std::string NodesGraph::CopyNodes(const std::vector<Node*>& nodes, ImVec2 origin)
+{
+	// Only top level nodes have a record in the snapshot, children are part of their group's.
+	std::vector<Node*> copiedNodes;
+	std::vector<std::string> nodeIds;
+	copiedNodes.reserve(nodes.size());
+	nodeIds.reserve(nodes.size());
+
+	for (auto node : nodes)
+	{
+		if (!_nodes.contains(node->GetId()))
+			continue;
+
+		copiedNodes.push_back(node);
+		nodeIds.push_back(node->GetId());
+	}
+
+	std::unordered_set<NodeSlot*> slots;
+	CollectSlots(copiedNodes, slots);
+
+	// Connections between the copied nodes, each is listed under both of its slots.
+	std::vector<std::string> connectionIds;
+	for (auto slot : slots)
+	{
+		for (auto connection : _slotConnections.Get(slot))
+		{
+			if (connection->GetFrom() == slot && slots.contains(connection->GetTo()))
+				connectionIds.push_back(connection->GetId());
+		}
+	}
+
+	// The snapshot already holds every node encoded, only the ones changed since the last one are encoded again.
+	return GraphClipboard::Encode(TakeRecordsSnapshot(), nodeIds, connectionIds, origin);
+}
+
+bool NodesGraph::PasteNodes(const std::string& text, ImVec2 position)
+{
+	std::vector<Node*> nodes;
+	std::vector<NodeConnection*> connections;
+	if (!GraphClipboard::Decode(text, position, CreateNode, nodes, connections) || nodes.empty())
+		return false;
+
+	Execute(new CreateNodesCommand(nodes, std::move(connections), this, "Paste Nodes"));
+
+	ClearSelection();
+	for (auto node : nodes)
+		SetNodeSelected(node, true);
+
+	return true;
+}
+
+void NodesGraph::DuplicateNodes(const std::vector<Node*>& nodes, ImVec2 offset)
+{
+	std::vector<Node*> clones;
+	std::vector<NodeConnection*> connections;
+	SubgraphCloner::Clone(nodes, _slotConnections, clones, connections);
+	if (clones.empty())
+		return;
+
+	for (auto clone : clones)
+	{
+		clone->SetPosition(clone->GetPosition() + offset);
+		clone->SetRecordedPosition(clone->GetPosition());
+	}
+
+	Execute(new CreateNodesCommand(clones, std::move(connections), this, "Duplicate Nodes"));
+
+	ClearSelection();
+	for (auto clone : clones)
+		SetNodeSelected(clone, true);
+}
+
+std::string NodesGraph::CreateTemplate(const std::string& name, const std::vector<Node*>& nodes)
+{
+	if (nodes.empty())
+		return std::string();
+
+	auto sortedNodes = nodes;
+	std::sort(sortedNodes.begin(), sortedNodes.end(), [](Node* a, Node* b) {
+		return a->GetPosition().x < b->GetPosition().x;
+		});
+
+	std::unordered_set<NodeSlot*> slots;
+	CollectSlots(sortedNodes, slots);
+
+	// Leftmost slots connected to the rest of the graph.
+	NodeSlot* input = nullptr;
+	NodeSlot* output = nullptr;
+	std::function<void(Node*)> findBoundary = [&](Node* node) {
+		for (auto slot : node->GetSlots())
+		{
+			for (auto connection : _slotConnections.Get(slot))
+			{
+				if (input == nullptr && connection->GetTo() == slot && !slots.contains(connection->GetFrom()))
+					input = slot;
+				if (output == nullptr && connection->GetFrom() == slot && !slots.contains(connection->GetTo()))
+					output = slot;
+			}
+		}
+
+		auto groupNode = node->AsGroup();
+		if (groupNode != nullptr)
+		{
+			for (auto child : groupNode->GetNodes())
+				findBoundary(child);
+		}
+	};
+
+	auto origin = sortedNodes[0]->GetPosition();
+	for (auto node : sortedNodes)
+	{
+		findBoundary(node);
+		origin = ImMin(origin, node->GetPosition());
+	}
+
+	auto data = CopyNodes(sortedNodes, origin);
+	return _templates.Add(name, std::move(data), sortedNodes.size(),
+		input != nullptr ? input->GetId() : std::string(), output != nullptr ? output->GetId() : std::string());
+}
+
+void NodesGraph::AddTemplateInstance(const std::string& templateId, ImVec2 position)
+{
+	auto node = CreateNode(TemplateNode::TypeName);
+	if (node == nullptr)
+		return;
+
+	auto instance = static_cast<TemplateNode*>(node);
+	instance->SetTemplateId(templateId);
+	instance->SetPosition(position);
+	instance->SetRecordedPosition(position);
+
+	Execute(new CreateNodeCommand(instance, this));
+}
+
+bool NodesGraph::ExpandTemplate(TemplateNode* instance)
+{
+	std::vector<Node*> nodes;
+	std::vector<NodeConnection*> connections;
+	NodeSlot* input = nullptr;
+	NodeSlot* output = nullptr;
+
+	if (!_templates.Instantiate(instance->GetTemplateId(), instance->GetPosition(), instance->GetOverrides(), nodes, connections, &input, &output))
+		return false;
+
+	auto command = new CommandCluster("Expand Template");
+
+	// Connections to the instance are moved to the template's boundary slots, or dropped if it has none.
+	std::vector<NodeConnection*> instanceConnections;
+	_slotConnections.Collect(instance, instanceConnections);
+	for (auto connection : instanceConnections)
+	{
+		command->Add(new DeleteConnectionCommand(connection, this));
+
+		auto isIncoming = connection->GetTo()->GetNode() == instance;
+		if (isIncoming && input != nullptr && connection->GetFrom()->GetNode() != instance)
+			connections.push_back(connection->Clone(connection->GetFrom(), input));
+		else if (!isIncoming && output != nullptr)
+			connections.push_back(connection->Clone(output, connection->GetTo()));
+	}
+
+	command->Add(new DeleteNodeCommand(instance, this));
+	command->Add(new CreateNodesCommand(nodes, std::move(connections), this, "Create Nodes"));
+	Execute(command);
+
+	ClearSelection();
+	for (auto node : nodes)
+		SetNodeSelected(node, true);
+
+	return true;
+}
+
+void NodesGraph::EnterSubgraph(SubgraphNode* node)
+{
+	LeaveSubgraph();
+
+	node->GetGraph();
+	node->SetEntered(true);
+	_enteredSubgraph = node;
+}
+
+void NodesGraph::LeaveSubgraph()
+{
+	if (_enteredSubgraph == nullptr)
+		return;
+
+	_enteredSubgraph->GetLoadedGraph()->LeaveSubgraph();
+	SyncSubgraph();
+
+	auto node = _enteredSubgraph;
+	_enteredSubgraph = nullptr;
+	node->SetEntered(false);
+}
+
+NodesGraph* NodesGraph::GetActiveGraph()
+{
+	auto graph = this;
+	while (graph->_enteredSubgraph != nullptr)
+		graph = graph->_enteredSubgraph->GetLoadedGraph();
+
+	return graph;
+}
+
+void NodesGraph::SyncSubgraph()
+{
+	if (_enteredSubgraph == nullptr)
+		return;
+
+	auto graph = _enteredSubgraph->GetLoadedGraph();
+	graph->SyncSubgraph();
+	if (!graph->HasUnsavedChanges())
+		return;
+
+	SubgraphContents contents;
+	contents.data = graph->Serialize();
+	contents.nodeCount = graph->GetNodes().size();
+	contents.connectionCount = graph->GetConnections().size();
+	Execute(new EditSubgraphCommand(_enteredSubgraph, std::move(contents), this));
+}
+
+void NodesGraph::DrawSubgraphPath()
+{
+	// Clicking a level leaves everything entered below it.
+	NodesGraph* leftGraph = nullptr;
+	if (ImGui::SmallButton("Graph"))
+		leftGraph = this;
+
+	for (auto graph = this; graph->_enteredSubgraph != nullptr; graph = graph->_enteredSubgraph->GetLoadedGraph())
+	{
+		auto node = graph->_enteredSubgraph;
+		ImGui::SameLine();
+		ImGui::TextDisabled(">");
+		ImGui::SameLine();
+
+		ImGui::PushID(node);
+		if (ImGui::SmallButton(node->GetLabel().empty() ? SubgraphNode::TypeName : node->GetLabel().c_str()))
+			leftGraph = node->GetLoadedGraph();
+		ImGui::PopID();
+	}
+
+	if (leftGraph != nullptr)
+		leftGraph->LeaveSubgraph();
+}
+
+SubgraphNode* NodesGraph::CollapseToSubgraph(const std::vector<Node*>& nodes)
+{
+	std::vector<Node*> innerNodes;
+	for (auto node : nodes)
+	{
+		if (_nodes.contains(node->GetId()))
+			innerNodes.push_back(node);
+	}
+
+	auto subgraphNode = innerNodes.empty() ? nullptr : CreateNode(SubgraphNode::TypeName);
+	if (subgraphNode == nullptr)
+		return nullptr;
+
+	auto subgraph = static_cast<SubgraphNode*>(subgraphNode);
+
+	// The inner graph gets clones, the nodes themselves are kept by the command for undo.
+	std::vector<Node*> clones;
+	std::vector<NodeConnection*> innerConnections;
+	std::unordered_map<NodeSlot*, NodeSlot*> clonedSlots;
+	SubgraphCloner::Clone(innerNodes, _slotConnections, clones, innerConnections, &clonedSlots);
+
+	auto command = new CommandCluster("Collapse to Subgraph");
+
+	// Every inner slot connected to the rest of the graph becomes a port, once per direction.
+	std::vector<NodeConnection*> crossingConnections;
+	std::vector<SubgraphPort> ports;
+	std::vector<NodeSlot*> portSlots;
+	std::unordered_map<NodeSlot*, size_t> inputPorts;
+	std::unordered_map<NodeSlot*, size_t> outputPorts;
+
+	std::unordered_set<NodeConnection*> deletedConnections;
+	for (auto node : innerNodes)
+	{
+		command->Add(new DeleteNodeCommand(node, this));
+
+		std::vector<NodeConnection*> connections;
+		_slotConnections.Collect(node, connections);
+		for (auto connection : connections)
+		{
+			if (!deletedConnections.insert(connection).second)
+				continue;
+
+			command->Add(new DeleteConnectionCommand(connection, this));
+
+			auto from = clonedSlots.find(connection->GetFrom());
+			auto to = clonedSlots.find(connection->GetTo());
+			if (from != clonedSlots.end() && to != clonedSlots.end())
+				continue;
+
+			auto isInput = to != clonedSlots.end();
+			auto slot = isInput ? to->second : from->second;
+			auto& slotPorts = isInput ? inputPorts : outputPorts;
+			if (slotPorts.emplace(slot, ports.size()).second)
+			{
+				ports.push_back({ slot->GetId(), isInput });
+				portSlots.push_back(slot);
+			}
+
+			crossingConnections.push_back(connection);
+		}
+	}
+
+	// Ports follow the vertical order of the slots' nodes.
+	std::vector<size_t> order(ports.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return portSlots[a]->GetNode()->GetPosition().y < portSlots[b]->GetNode()->GetPosition().y;
+		});
+
+	std::vector<SubgraphPort> sortedPorts;
+	std::vector<size_t> portIndex(ports.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		sortedPorts.push_back(ports[order[i]]);
+		portIndex[order[i]] = i;
+	}
+
+	subgraph->SetPorts(sortedPorts);
+
+	std::vector<NodeConnection*> connections;
+	for (auto connection : crossingConnections)
+	{
+		auto to = clonedSlots.find(connection->GetTo());
+		if (to != clonedSlots.end())
+		{
+			auto port = subgraph->GetSlots()[portIndex[inputPorts.at(to->second)]];
+			connections.push_back(connection->Clone(connection->GetFrom(), port));
+		}
+		else
+		{
+			auto port = subgraph->GetSlots()[portIndex[outputPorts.at(clonedSlots.at(connection->GetFrom()))]];
+			connections.push_back(connection->Clone(port, connection->GetTo()));
+		}
+	}
+
+	auto boundsMin = innerNodes[0]->GetPosition();
+	for (auto node : innerNodes)
+		boundsMin = ImMin(boundsMin, node->GetPosition());
+
+	// Encoded as the inner graph would save them, without creating the graph.
+	EncodedChunks<Node> encodedNodes;
+	EncodedChunks<NodeConnection> encodedConnections;
+	for (auto clone : clones)
+		encodedNodes.Set(clone->GetId(), clone);
+	for (auto connection : innerConnections)
+		encodedConnections.Set(connection->GetId(), connection);
+
+	// The view starts at the top left of the nodes.
+	auto offset = ImVec2(48_dpi, 48_dpi) - boundsMin;
+	auto dpiScale = NodesGraphSettings::GetDpiScale();
+	auto& nodeChunks = encodedNodes.Publish(EncodeNode);
+	auto& connectionChunks = encodedConnections.Publish(EncodeConnection);
+
+	nlohmann::json jsonHeader;
+	jsonHeader["id"] = Guid::CreateGuid();
+	jsonHeader["node_count"] = clones.size();
+	jsonHeader["connection_count"] = innerConnections.size();
+	jsonHeader["hash"] = FormatHash(GraphSnapshot::HashChunks(nodeChunks, connectionChunks));
+
+	GraphSnapshot snapshot(nodeChunks, connectionChunks, _defaultScaleIndex, offset.x / dpiScale, offset.y / dpiScale, 0, jsonHeader.dump());
+
+	SubgraphContents contents;
+	contents.data = snapshot.Serialize();
+	contents.nodeCount = clones.size();
+	contents.connectionCount = innerConnections.size();
+	subgraph->SetContents(contents);
+
+	for (auto clone : clones)
+		delete clone;
+	for (auto connection : innerConnections)
+		delete connection;
+
+	subgraph->SetPosition(boundsMin);
+	subgraph->SetRecordedPosition(boundsMin);
+
+	command->Add(new CreateNodesCommand({ subgraph }, std::move(connections), this, "Create Nodes"));
+	Execute(command);
+
+	ClearSelection();
+	SetNodeSelected(subgraph, true);
+
+	return subgraph;
+}
+
+bool NodesGraph::DissolveSubgraph(SubgraphNode* node)
+{
+	if (node == _enteredSubgraph)
+		LeaveSubgraph();
+
+	auto graph = node->GetGraph();
+
+	std::vector<Node*> innerNodes;
+	innerNodes.reserve(graph->GetNodes().size());
+	for (const auto& [_, innerNode] : graph->GetNodes())
+		innerNodes.push_back(innerNode);
+
+	std::vector<Node*> nodes;
+	std::vector<NodeConnection*> connections;
+	std::unordered_map<NodeSlot*, NodeSlot*> clonedSlots;
+	SubgraphCloner::Clone(innerNodes, graph->GetSlotConnections(), nodes, connections, &clonedSlots);
+
+	std::vector<NodeSlot*> portSlots;
+	node->ResolvePorts(portSlots);
+
+	if (!nodes.empty())
+	{
+		auto boundsMin = nodes[0]->GetPosition();
+		for (auto clone : nodes)
+			boundsMin = ImMin(boundsMin, clone->GetPosition());
+
+		auto offset = node->GetPosition() - boundsMin;
+		for (auto clone : nodes)
+		{
+			clone->SetPosition(clone->GetPosition() + offset);
+			clone->SetRecordedPosition(clone->GetPosition());
+		}
+	}
+
+	auto command = new CommandCluster("Dissolve Subgraph");
+
+	// Connections to the ports continue from/to the inner slots, ports whose slot is gone drop them.
+	std::vector<NodeConnection*> nodeConnections;
+	_slotConnections.Collect(node, nodeConnections);
+	for (auto connection : nodeConnections)
+	{
+		command->Add(new DeleteConnectionCommand(connection, this));
+
+		auto from = connection->GetFrom();
+		auto to = connection->GetTo();
+		if (from->GetNode() == node && to->GetNode() == node)
+			continue;
+
+		auto& slots = node->GetSlots();
+		auto portSlot = to->GetNode() == node ? to : from;
+		auto port = std::find(slots.begin(), slots.end(), portSlot) - slots.begin();
+		auto innerSlot = port < (ptrdiff_t)portSlots.size() ? portSlots[port] : nullptr;
+		if (innerSlot == nullptr)
+			continue;
+
+		if (portSlot == to)
+			connections.push_back(connection->Clone(from, clonedSlots.at(innerSlot)));
+		else
+			connections.push_back(connection->Clone(clonedSlots.at(innerSlot), to));
+	}
+
+	command->Add(new DeleteNodeCommand(node, this));
+	command->Add(new CreateNodesCommand(nodes, std::move(connections), this, "Create Nodes"));
+	Execute(command);
+
+	// Kept by the command for undo, the inner graph is loaded again if needed.
+	node->SetEntered(false);
+
+	ClearSelection();
+	for (auto clone : nodes)
+		SetNodeSelected(clone, true);
+
+	return true;
+}
+
+void NodesGraph::DrawUnreachableOutline(Node* node)
+{
+	auto padding = ImVec2(3_dpi, 3_dpi);
+	auto min = ImFloor(node->GetPosition()) - padding;
+	auto max = ImFloor(node->GetPosition()) + node->GetSize() + padding;
+
+	_drawList->AddRect(min, max, _colorUnreachable, 1.0f, 0, 2_dpi);
+}
+
+void NodesGraph::HandleNodesDragging()
+{
+	if (_isDraggingNodes)
+	{
+		if (_draggedNode != nullptr) {
+			_draggedNodePos += _io.MouseDelta;
+			auto pos = _draggedNodePos;
+
+			if (NodesGraphSettings::NodeSnappingEnabled() && !ImGui::IsKeyDown(ImGuiKey_LeftAlt)) {
+				auto snap = NodesGraphSettings::NodeSnappingValue();
+				pos = ImVec2(((int)(_draggedNodePos.x + 2) / snap) * snap, ((int)(_draggedNodePos.y + 2) / snap) * snap);
+			}
+
+			_draggedNode->SetPosition(pos);
+		}
+		else {
+			for (auto& node : _selectedNodes)
 				node->SetPosition(node->GetPosition() + _io.MouseDelta);
 		}
 
@@ -571,16 +1823,18 @@ void NodesGraph::HandleNodesDragging()
 
 			if (_draggedNode != nullptr)
 			{
-				_commands.Execute(new MoveNodeCommand(_draggedNode, _draggedNode->GetPosition()));
+				Execute(new MoveNodeCommand(_draggedNode, _draggedNode->GetPosition(), this));
 				_draggedNode = nullptr;
 			}
 			else
 			{
-				auto command = new CommandCluster("Move Nodes");
-				for (const auto& n : _selectedNodes)
-					command->Add(new MoveNodeCommand(n, n->GetPosition()));
+				auto nodes = GetSelection();
+				std::vector<ImVec2> positions;
+				positions.reserve(nodes.size());
+				for (auto node : nodes)
+					positions.push_back(node->GetPosition());
 
-				_commands.Execute(command);
+				MoveNodesTo(nodes, positions, MoveNodesCommand::DragLabel);
 			}
 		}
 	}
@@ -662,11 +1916,11 @@ void NodesGraph::DrawConnections()
 
 				if (_clickedConnection->GetTo() != to || _clickedConnection->GetFrom() != from)
 				{
-					_commands.Execute(new EditConnectionCommand(_clickedConnection, from, to));
+					Execute(new EditConnectionCommand(_clickedConnection, from, to, this));
 				}
 			}
 			else
-				_commands.Execute(new DeleteConnectionCommand(_clickedConnection, &_connections));
+				Execute(new DeleteConnectionCommand(_clickedConnection, this));
 
 			_clickedConnection = nullptr;
 			_isEditingConnection = false;
@@ -707,31 +1961,38 @@ void NodesGraph::DrawContextMenus()
 
 		if (ImGui::BeginMenu("Add"))
 		{
-			for (const auto& [key, fn] : _nodesRegistry)
+			for (const auto& nodeType : _nodeTypes)
 			{
-				if (ImGui::MenuItem(key.c_str()))
+				// Instances are added from the "Templates" menu, subgraphs are made from nodes.
+				if (nodeType.label == TemplateNode::TypeName || nodeType.label == SubgraphNode::TypeName)
+					continue;
+
+				if (ImGui::MenuItem(nodeType.label.c_str()))
 				{
-					auto node = fn(canvasPos);
+					auto node = nodeType.create(canvasPos);
 					node->PreDraw(_drawList);
-					Execute(new CreateNodeCommand(node, &_nodes));
+					Execute(new CreateNodeCommand(node, this));
 				}
 			}
 			ImGui::EndMenu();
 		}
 
-		ImGui::BeginDisabled(_copiedNodes.size() == 0);
-		if (ImGui::MenuItem("Paste"))
+		if (!_templates.IsEmpty() && FindNodeType(TemplateNode::TypeName) >= 0 && ImGui::BeginMenu("Templates"))
 		{
-			for (const auto& node : _copiedNodes)
+			for (const auto& [id, graphTemplate] : _templates.GetTemplates())
 			{
-				auto offset = node->GetPosition() - _copiedNode->GetPosition();
-				node->SetPosition(canvasPos + offset);
-				node->SetRecordedPosition(node->GetPosition());
+				ImGui::PushID(id.c_str());
+				if (ImGui::MenuItem(graphTemplate.name.c_str()))
+					AddTemplateInstance(id, canvasPos);
+				ImGui::PopID();
 			}
-
-			Execute(_copyNodesCommand);
-			_copiedNodes.clear();
+			ImGui::EndMenu();
 		}
+
+		auto clipboardText = ImGui::GetClipboardText();
+		ImGui::BeginDisabled(!GraphClipboard::IsSubgraph(clipboardText));
+		if (ImGui::MenuItem("Paste"))
+			PasteNodes(clipboardText, canvasPos);
 		ImGui::EndDisabled();
 		ImGui::EndPopup();
 	}
@@ -759,7 +2020,7 @@ void NodesGraph::DrawContextMenus()
 		}
 
 		if (typeValue != _focusedConnection->GetType())
-			Execute(new EditValueCommand<int>(_focusedConnection->GetTypePtr(), typeValue));
+			Execute(new EditValueCommand<int>(_focusedConnection->GetTypePtr(), typeValue, this, _focusedConnection));
 
 		ImGui::Spacing();
 		ImGui::Separator();
@@ -768,167 +2029,142 @@ void NodesGraph::DrawContextMenus()
 		ImGui::SetNextItemWidth(avail.x);
 		NodesGraph::Input::Float("##V", _focusedConnection->GetValuePtr(), .1f);
 		if (ImGui::MenuItem("Delete"))
-			_commands.Execute(new DeleteConnectionCommand(_focusedConnection, &_connections));
+			Execute(new DeleteConnectionCommand(_focusedConnection, this));
 
 		ImGui::EndPopup();
 	}
 
 	if (ImGui::BeginPopup(NODE_CONTEXT_MENU))
 	{
-		auto deleteNode = [this](Node* node, CommandCluster* command) {
-			command->Add(new DeleteNodeCommand(node, &_nodes));
+		std::unordered_set<NodeConnection*> deletedConnections;
+		auto deleteNode = [this, &deletedConnections](Node* node, CommandCluster* command) {
+			command->Add(new DeleteNodeCommand(node, this));
 
-			auto groupNode = dynamic_cast<_GroupNode*>(node);
-			for (const auto& [_, connection] : _connections)
+			std::vector<NodeConnection*> connections;
+			_slotConnections.Collect(node, connections);
+			for (auto connection : connections)
 			{
-				for (const auto& slot : node->GetSlots())
-				{
-					if (connection->GetFrom() == slot || connection->GetTo() == slot)
-						command->Add(new DeleteConnectionCommand(connection, &_connections));
-				}
-
-				if (groupNode)
-				{
-					for (const auto& childNode : groupNode->GetNodes())
-					{
-						for (const auto& slot : childNode->GetSlots())
-						{
-							if (connection->GetFrom() == slot || connection->GetTo() == slot)
-								command->Add(new DeleteConnectionCommand(connection, &_connections));
-						}
-					}
-				}
+				if (deletedConnections.insert(connection).second)
+					command->Add(new DeleteConnectionCommand(connection, this));
 			}
 			};
 
 		auto isSelected = _selectedNodes.size() > 1 && _selectedNodes.find(_focusedNode) != _selectedNodes.end();
 		auto text = isSelected ? "Nodes" : "Node";
+
+		// -1 while the type isn't registered.
+		auto subgraphTypeId = FindNodeType(SubgraphNode::TypeName);
+		auto templateTypeId = FindNodeType(TemplateNode::TypeName);
 		ImGui::SeparatorText(text);
 		if (ImGui::MenuItem("Delete"))
 		{
 			if (!isSelected) {
 				auto command = new CommandCluster("Delete Node");
 				deleteNode(_focusedNode, command);
-				_commands.Execute(command);
+				Execute(command);
 			}
 			else {
 				auto command = new CommandCluster("Delete Nodes");
 				for (const auto& node : _selectedNodes)
 					deleteNode(node, command);
-				_commands.Execute(command);
+				Execute(command);
 			}
 		}
 		if (ImGui::MenuItem("Copy"))
 		{
-			if (_copyNodesCommand != nullptr && _copyNodesCommand->GetState() == Created)
-				delete _copyNodesCommand;
+			auto nodes = isSelected ? GetSelection() : std::vector<Node*>{ _focusedNode };
+			ImGui::SetClipboardText(CopyNodes(nodes, _focusedNode->GetPosition()).c_str());
+		}
+		if (ImGui::MenuItem("Duplicate"))
+		{
+			auto nodes = isSelected ? GetSelection() : std::vector<Node*>{ _focusedNode };
+			DuplicateNodes(nodes, ImVec2(20_dpi, 20_dpi));
+		}
+		if (ImGui::BeginMenu("Save as Template"))
+		{
+			ImGui::SetNextItemWidth(192_dpi);
+			ImGui::InputTextWithHint("##Name", "Name", &_templateName);
 
-			_copiedNodes.clear();
+			ImGui::BeginDisabled(_templateName.empty());
+			if (ImGui::Button("Save"))
+			{
+				auto nodes = isSelected ? GetSelection() : std::vector<Node*>{ _focusedNode };
+				CreateTemplate(_templateName, nodes);
+				_templateName.clear();
+				ImGui::CloseCurrentPopup();
+			}
+			ImGui::EndDisabled();
+			ImGui::EndMenu();
+		}
 
-			_copyNodesCommand = new CommandCluster("Paste Nodes");
+		if (subgraphTypeId >= 0 && ImGui::MenuItem("Collapse to Subgraph"))
+		{
+			auto nodes = isSelected ? GetSelection() : std::vector<Node*>{ _focusedNode };
+			CollapseToSubgraph(nodes);
+		}
 
-			std::map<NodeConnection*, std::tuple<Node*, int>> connectionsFrom;
-			std::map<NodeConnection*, std::tuple<Node*, int>> connectionsTo;
-			std::map<Node*, Node*> nodesCreated;
+		if (subgraphTypeId >= 0 && _focusedNode->GetTypeId() == subgraphTypeId)
+		{
+			auto subgraph = static_cast<SubgraphNode*>(_focusedNode);
+			ImGui::SeparatorText("Subgraph");
+			if (ImGui::MenuItem("Enter"))
+				EnterSubgraph(subgraph);
+			if (ImGui::MenuItem("Preview", nullptr, subgraph->IsExpanded()))
+				subgraph->SetExpanded(!subgraph->IsExpanded());
+			if (ImGui::MenuItem("Dissolve"))
+				DissolveSubgraph(subgraph);
+		}
 
-			auto copyNodeConnections = [this, &connectionsFrom, &connectionsTo, &nodesCreated](Node* node) {
-				for (const auto& [key, connection] : _connections)
-				{
-					int slotIndex = 0;
-					for (const auto& slot : node->GetSlots())
-					{
-						if (connection->GetFrom() == slot)
-						{
-							auto iter = connectionsTo.find(connection);
-							if (iter != connectionsTo.end())
-							{
-								auto slotFrom = nodesCreated.at(node)->GetSlots()[slotIndex];
-								auto slotTo = nodesCreated.at(std::get<0>(iter->second))->GetSlots()[std::get<1>(iter->second)];
-
-								auto newConnection = new NodeConnection(slotFrom, slotTo);
-								_copyNodesCommand->Add(new CreateConnectionCommand(newConnection, &_connections));
-								connectionsTo.erase(connection);
-							}
-							else
-							{
-								connectionsFrom.emplace(connection, std::make_tuple(node, slotIndex));
-							}
-						}
-						else if (connection->GetTo() == slot)
-						{
-							auto iter = connectionsFrom.find(connection);
-							if (iter != connectionsFrom.end())
-							{
-								auto slotTo = nodesCreated.at(node)->GetSlots()[slotIndex];
-								auto slotFrom = nodesCreated.at(std::get<0>(iter->second))->GetSlots()[std::get<1>(iter->second)];
-
-								auto newConnection = new NodeConnection(slotFrom, slotTo);
-								_copyNodesCommand->Add(new CreateConnectionCommand(newConnection, &_connections));
-								connectionsFrom.erase(connection);
-							}
-							else
-							{
-								connectionsTo.emplace(connection, std::make_tuple(node, slotIndex));
-							}
-						}
-
-						slotIndex++;
-					}
-				}
-				};
+		if (templateTypeId >= 0 && _focusedNode->GetTypeId() == templateTypeId)
+		{
+			auto instance = static_cast<TemplateNode*>(_focusedNode);
+			ImGui::SeparatorText("Template");
+			if (ImGui::MenuItem("Expand"))
+				ExpandTemplate(instance);
 
-			if (_selectedNodes.size() > 0)
+			auto prototype = _templates.GetPrototype(instance->GetTemplateId());
+			if (ImGui::BeginMenu("Overrides", prototype != nullptr))
 			{
-				for (const auto& node : _selectedNodes)
+				// Labels of the template's nodes, empty to use the template's.
+				for (auto node : prototype->nodes)
 				{
-					auto copy = node->Clone();
-					_copyNodesCommand->Add(new CreateNodeCommand(copy, &_nodes));
+					ImGui::PushID(node->GetId().c_str());
+					auto label = instance->GetOverride(node->GetId(), "label");
+					ImGui::SetNextItemWidth(192_dpi);
+					ImGui::InputTextWithHint("##Label", node->GetLabel().c_str(), &label);
 
-					nodesCreated.emplace(node, copy);
-					_copiedNodes.emplace(copy);
-					copyNodeConnections(node);
-
-					auto groupNode = dynamic_cast<_GroupNode*>(node);
-					auto groupNodeCopy = dynamic_cast<_GroupNode*>(copy);
-					if (groupNode)
+					if (ImGui::IsItemDeactivatedAfterEdit())
 					{
-						auto& childNodes = groupNode->GetNodes();
-						auto& childNodesCopies = groupNodeCopy->GetNodes();
-						for (int i = 0; i < childNodes.size(); i++)
-						{
-							auto childNode = childNodes[i];
-							auto childNodeCopy = childNodesCopies[i];
-							nodesCreated.emplace(childNode, childNodeCopy);
-							copyNodeConnections(childNode);
-						}
+						auto previous = instance->GetOverrides();
+						instance->SetOverride(node->GetId(), "label", label);
+						Execute(new EditValueCommand<nlohmann::json>(instance->GetOverridesPtr(), previous, this, instance));
 					}
+					ImGui::PopID();
 				}
+				ImGui::EndMenu();
 			}
-			else {
-				auto copy = _focusedNode->Clone();
-				_copyNodesCommand->Add(new CreateNodeCommand(copy, &_nodes));
-
-				nodesCreated.emplace(_focusedNode, copy);
-				_copiedNodes.emplace(copy);
-				copyNodeConnections(_focusedNode);
+		}
 
-				auto groupNode = dynamic_cast<_GroupNode*>(_focusedNode);
-				auto groupNodeCopy = dynamic_cast<_GroupNode*>(copy);
-				if (groupNode)
-				{
-					auto& childNodes = groupNode->GetNodes();
-					auto& childNodesCopies = groupNodeCopy->GetNodes();
-					for (int i = 0; i < childNodes.size(); i++)
-					{
-						auto childNode = childNodes[i];
-						auto childNodeCopy = childNodesCopies[i];
-						nodesCreated.emplace(childNode, childNodeCopy);
-						copyNodeConnections(childNode);
-					}
-				}
+		if (isSelected)
+		{
+			if (ImGui::BeginMenu("Align"))
+			{
+				if (ImGui::MenuItem("Left")) AlignSelection(NodeAlignment_Left);
+				if (ImGui::MenuItem("Right")) AlignSelection(NodeAlignment_Right);
+				if (ImGui::MenuItem("Top")) AlignSelection(NodeAlignment_Top);
+				if (ImGui::MenuItem("Bottom")) AlignSelection(NodeAlignment_Bottom);
+				if (ImGui::MenuItem("Center Horizontally")) AlignSelection(NodeAlignment_CenterX);
+				if (ImGui::MenuItem("Center Vertically")) AlignSelection(NodeAlignment_CenterY);
+				ImGui::EndMenu();
 			}
-
-			_copiedNode = _focusedNode;
+			if (ImGui::BeginMenu("Distribute", _selectedNodes.size() > 2))
+			{
+				if (ImGui::MenuItem("Horizontally")) DistributeSelection(true);
+				if (ImGui::MenuItem("Vertically")) DistributeSelection(false);
+				ImGui::EndMenu();
+			}
+			if (ImGui::MenuItem("Pack"))
+				PackSelection();
 		}
 
 		auto contextMenu = GetNodeContextMenu(_focusedNode);
@@ -943,22 +2179,33 @@ void NodesGraph::DrawContextMenus()
 
 	if (ImGui::BeginPopup(CHILD_NODE_CONTEXT_MENU))
 	{
-		ImGui::SeparatorText("Child Node");
+		auto isSelected = _selectedChildNodes.size() > 1 && _selectedChildNodes.contains(_focusedChildNode);
+		ImGui::SeparatorText(isSelected ? "Child Nodes" : "Child Node");
 		if (ImGui::MenuItem("Delete"))
 		{
-			auto command = new CommandCluster("Delete Child Node");
-			command->Add(new DeleteChildNodeCommand(_focusedChildNode, &_focusedChildNodeParent->GetNodes()));
+			std::vector<std::pair<Node*, _GroupNode*>> childNodes;
+			if (isSelected)
+				childNodes.assign(_selectedChildNodes.begin(), _selectedChildNodes.end());
+			else
+				childNodes.emplace_back(_focusedChildNode, _focusedChildNodeParent);
 
-			for (const auto& [_, connection] : _connections)
+			auto command = new CommandCluster(isSelected ? "Delete Child Nodes" : "Delete Child Node");
+			std::unordered_set<NodeConnection*> deletedConnections;
+
+			for (const auto& [childNode, parent] : childNodes)
 			{
-				for (const auto& slot : _focusedChildNode->GetSlots())
+				command->Add(new DeleteChildNodeCommand(childNode, parent, this));
+
+				std::vector<NodeConnection*> connections;
+				_slotConnections.Collect(childNode, connections);
+				for (auto connection : connections)
 				{
-					if (connection->GetFrom() == slot || connection->GetTo() == slot)
-						command->Add(new DeleteConnectionCommand(connection, &_connections));
+					if (deletedConnections.insert(connection).second)
+						command->Add(new DeleteConnectionCommand(connection, this));
 				}
 			}
 
-			_commands.Execute(command);
+			Execute(command);
 		}
 
 		auto contextMenu = GetNodeContextMenu(_focusedChildNode);
@@ -981,8 +2228,7 @@ void NodesGraph::DrawSelection()
 		!ImGui::IsAnyItemHovered() && !_hoveredConnection &&
 		ImGui::IsMouseClicked(ImGuiMouseButton_Left))
 	{
-		_isDrawingSelection = true;
-		_drawingSelectionFrom = ImGui::GetMousePos();
+		BeginRectangleSelection();
 	}
 
 	if (_isDrawingSelection)
@@ -1009,7 +2255,7 @@ void NodesGraph::DrawConnectionAttempt()
 			if (_hoveredSlot != NULL && _hoveredSlot != _drawingConnectionFrom)
 			{
 				auto connection = new NodeConnection(_drawingConnectionFrom, _hoveredSlot);
-				_commands.Execute(new CreateConnectionCommand(connection, &_connections));
+				Execute(new CreateConnectionCommand(connection, this));
 			}
 		}
 	}
@@ -1084,11 +2330,11 @@ void NodesGraph::Input::Float(const char* label, float* v, float step, float ste
 
 	if (ImGui::IsItemDeactivatedAfterEdit()) {
 		if (_previousFloatValue != *v)
-			_current->Execute(new EditValueCommand<float>(v, _previousFloatValue));
+			_current->Execute(new EditValueCommand<float>(v, _previousFloatValue, _current, _current->_focusedConnection));
 	}
 	else if (ImGui::IsItemEdited() && ImGui::IsItemActivated() && previousValue != *v)
 	{
 		if (previousValue != *v)
-			_current->Execute(new EditValueCommand<float>(v, previousValue));
+			_current->Execute(new EditValueCommand<float>(v, previousValue, _current, _current->_focusedConnection));
 	}
 }
\ No newline at end of file
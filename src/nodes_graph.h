@@ -8,6 +8,7 @@
 // std
 #include <map>
 #include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <typeindex>
 
@@ -16,47 +17,220 @@
 #include "node_connection.h"
 #include "node_slot.h"
 #include "commands.h"
+#include "command_queue.h"
 #include "literals.h"
+#include "graph_reachability.h"
+#include "node_key_index.h"
+#include "search_index.h"
+#include "node_layout.h"
+#include "undo_journal.h"
+#include "encoded_chunks.h"
+#include "graph_snapshot.h"
+#include "slot_map.h"
+#include "graph_clipboard.h"
+#include "slot_connections.h"
+#include "graph_templates.h"
+#include "graph_project.h"
+
+enum NodeAlignment {
+	NodeAlignment_Left,
+	NodeAlignment_Right,
+	NodeAlignment_Top,
+	NodeAlignment_Bottom,
+	NodeAlignment_CenterX,
+	NodeAlignment_CenterY
+};
+
+class TemplateNode;
+class SubgraphNode;
 
 class NodesGraph {
 public:
+	NodesGraph();
 	~NodesGraph();
 
 	void Draw();
 
 	void Deserialize(std::string data);
 	std::string Serialize();
+	// O(1) frozen copy of what Serialize would write, without marking the graph
+	// as saved. Safe to read from other threads while the graph keeps changing.
+	GraphSnapshot TakeSnapshot();
 
 	void Execute(_Command* command);
 
+	// Thread-safe: queues a command from any thread. Queued commands are executed
+	// at the start of the next Draw, batched into a single command. TryPost fails
+	// instead of waiting when the queue is full.
+	inline void Post(_Command* command) { _commandQueue.Post(command); }
+	inline bool TryPost(_Command* command) { return _commandQueue.TryPost(command); }
+	inline size_t GetQueuedCommandCount() const { return _commandQueue.Size(); }
+
 	void Undo();
 	std::vector<_Command*>& GetUndoStack();
 
 	void Redo();
 	std::vector<_Command*>& GetRedoStack();
-
-	bool HasUnsavedChanges() const;
+	size_t GetHistoryMemoryUsage() const;
+
+	// Compares the content hash with the one saved, see GetContentHash.
+	bool HasUnsavedChanges();
+	// Marks the current state as saved, as Serialize does.
+	void MarkSaved();
+	// Whether Serialize would write the document last loaded or saved, with the
+	// same header and view too (e.g. after undoing back to it).
+	bool IsSerializedUnchanged();
+	// Hash of the saved nodes and connections (see GraphSnapshot::GetContentHash),
+	// brought up to date with the nodes changed since the last call.
+	uint64_t GetContentHash();
+	// Persistent, saved in the header of the file.
+	inline const std::string& GetId() const { return _id; }
+	// Bumped after every command that changed the graph.
+	inline uint64_t GetChangeVersion() const { return _changeVersion; }
 	inline float GetScale() const { return _scale; };
 	inline ImVec2 GetOffset() const { return _offset; }
 	inline ImVec2 GetWindowPos() const { return _windowPos; }
 	inline ImVec2 GetWindowSize() const { return _windowSize; }
-	inline std::map<std::string, Node*>& GetNodes() { return _nodes; }
-	inline std::map<std::string, NodeConnection*>& GetConnections() { return _connections; }
+	inline SlotMap<Node*>& GetNodes() { return _nodes; }
+	inline SlotMap<NodeConnection*>& GetConnections() { return _connections; }
 
+	// Before the graph is first drawn, the position is centered again once the window size is known.
 	void FocusPosition(const ImVec2& position);
 	void FocusOnNode(Node* node);
+	// Draws the node above all others; it is also brought to the front when clicked.
+	void BringToFront(Node* node);
+
+	// Arrange the selected nodes, each operation is a single MoveNodesCommand.
+	void AlignSelection(NodeAlignment alignment);
+	// Spaces the nodes evenly between the outermost two.
+	void DistributeSelection(bool horizontally);
+	// Packs the nodes into rows at the top left of the selection, in reading order.
+	void PackSelection();
+
+	// Clipboard text (see GraphClipboard) of the nodes and the connections
+	// between them, `origin` is the point that will be under the cursor when pasted.
+	std::string CopyNodes(const std::vector<Node*>& nodes, ImVec2 origin);
+	// Pastes clipboard text as a single command and selects the pasted nodes.
+	bool PasteNodes(const std::string& text, ImVec2 position);
+	// Clones the nodes and the connections between them, offset by `offset`, as a single command.
+	void DuplicateNodes(const std::vector<Node*>& nodes, ImVec2 offset);
+
+	// Templates are shared by all graphs, TemplateNode must be registered to instance them.
+	inline static TemplateLibrary& GetTemplates() { return _templates; }
+	// The graph files open in the editor, for resolving keys across graphs.
+	inline static GraphProject& GetProject() { return _project; }
+	// Adds the nodes to the library as a template, the first input and output
+	// slot connected to the rest of the graph become the template's boundary.
+	std::string CreateTemplate(const std::string& name, const std::vector<Node*>& nodes);
+	void AddTemplateInstance(const std::string& templateId, ImVec2 position);
+	// Replaces the instance with the template's nodes as a single command.
+	bool ExpandTemplate(TemplateNode* instance);
+
+	// Hierarchical subgraphs, SubgraphNode must be registered. While a subgraph
+	// node is entered, Draw shows its inner graph with a path back to this one,
+	// and the edits made inside are recorded here as one change of the node
+	// when it is left or this graph is saved.
+	void EnterSubgraph(SubgraphNode* node);
+	void LeaveSubgraph();
+	// The graph being drawn and edited: the innermost entered subgraph, or this one.
+	NodesGraph* GetActiveGraph();
+	// Moves the nodes into a new subgraph node as a single command. Connections
+	// to the rest of the graph go through the node's ports.
+	SubgraphNode* CollapseToSubgraph(const std::vector<Node*>& nodes);
+	// Replaces the subgraph node with the nodes of its inner graph as a single command.
+	bool DissolveSubgraph(SubgraphNode* node);
+
+	// Model mutations, used by the commands so the graph can keep its analyses in sync.
+	void AddNode(Node* node);
+	void RemoveNode(Node* node);
+	void InsertChildNode(_GroupNode* parent, Node* node, size_t index);
+	size_t RemoveChildNode(_GroupNode* parent, Node* node);
+	void AddConnection(NodeConnection* connection);
+	void RemoveConnection(NodeConnection* connection);
+	// Batched versions of the above, large batches rebuild the analyses once
+	// instead of updating them per node/connection.
+	void AddNodes(const std::vector<Node*>& nodes, const std::vector<NodeConnection*>& connections);
+	void RemoveNodes(const std::vector<Node*>& nodes, const std::vector<NodeConnection*>& connections);
+	void SetConnectionSlots(NodeConnection* connection, NodeSlot* from, NodeSlot* to);
+	void OnNodeChanged(Node* node);
+	// Cheaper than OnNodeChanged, the position doesn't affect the indices.
+	void OnNodeMoved(Node* node);
+	void OnConnectionChanged(NodeConnection* connection);
+
+	// Crash recovery: changes are journaled next to the saved file until the next save.
+	bool OpenJournal(const std::string& path);
+	void CloseJournal(bool discard = false);
+	void Recover(const std::string& data, const std::string& journalData);
+
+	inline const GraphReachability& GetReachability() const { return _reachability; }
+	inline const NodeKeyIndex& GetKeyIndex() const { return _keyIndex; }
+	inline const SearchIndex& GetSearchIndex() const { return _searchIndex; }
+	inline const SlotConnections& GetSlotConnections() const { return _slotConnections; }
+
+	// The node whose contents are being drawn, so edits made by its widgets can be attributed to it.
+	inline Node* GetCurrentNode() const { return _currentNode; }
+
+	// Descriptor shared by all nodes of a registered type. Nodes carry the type id
+	// and flags, so hot paths can branch on integers instead of casting.
+	struct NodeType {
+		std::string label;
+		int flags;
+		int slotCount;
+		uint32_t inputSlots;
+		uint32_t outputSlots;
+		std::function<Node* (ImVec2 pos)> create;
+	};
 
 	template<DerivedFromNode T>
-	inline static void RegisterNode(std::string label) {
-		_nodesRegistry[label] = [label](ImVec2 pos) -> Node* {
+	inline static int RegisterNode(std::string label) {
+		auto it = _nodeTypeIds.find(label);
+		int typeId = it != _nodeTypeIds.end() ? it->second : (int)_nodeTypes.size();
+		if ((size_t)typeId == _nodeTypes.size())
+			_nodeTypes.emplace_back();
+
+		// Instance flags and slots are only known after initialization.
+		T prototype;
+		prototype.Init();
+
+		int flags = NodeTypeFlags_None;
+		if (std::is_base_of<_GroupNode, T>::value) flags |= NodeTypeFlags_Group;
+		if (prototype.IsEntry()) flags |= NodeTypeFlags_Entry;
+		if (prototype.IsExit()) flags |= NodeTypeFlags_Exit;
+
+		auto& nodeType = _nodeTypes[typeId];
+		nodeType.label = label;
+		nodeType.flags = flags;
+		nodeType.slotCount = (int)prototype.GetSlots().size();
+		nodeType.inputSlots = 0;
+		nodeType.outputSlots = 0;
+
+		for (int i = 0; i < nodeType.slotCount && i < 32; i++) {
+			if (prototype.GetSlots()[i]->IsInput()) nodeType.inputSlots |= 1u << i;
+			if (prototype.GetSlots()[i]->IsOutput()) nodeType.outputSlots |= 1u << i;
+		}
+
+		nodeType.create = [label, typeId, flags](ImVec2 pos) -> Node* {
 			auto node = new T();
 			node->Init();
 			node->SetType(label);
+			node->SetTypeInfo(typeId, flags);
 			node->SetLabel(label);
 			node->SetPosition(pos);
 			node->SetRecordedPosition(pos);
 			return node;
 			};
+
+		_nodeTypeIds[label] = typeId;
+		return typeId;
+	}
+
+	inline static const NodeType* GetNodeType(int typeId) {
+		return typeId >= 0 && (size_t)typeId < _nodeTypes.size() ? &_nodeTypes[typeId] : nullptr;
+	}
+
+	inline static int FindNodeType(const std::string& label) {
+		auto it = _nodeTypeIds.find(label);
+		return it != _nodeTypeIds.end() ? it->second : -1;
 	}
 
 	template<DerivedFromNode T>
@@ -74,8 +248,56 @@ public:
 private:
 	inline static NodesGraph* _current;
 
+	SubgraphNode* _enteredSubgraph = nullptr;
+	void SyncSubgraph();
+	void DrawSubgraphPath();
+	void DrawCanvas();
+
+	std::string _id;
 	Commands _commands;
-	int _savedCommandIndex = 0;
+
+	CommandQueue _commandQueue;
+	inline static const size_t _maxQueuedCommandsPerFrame = 1024;
+	void ExecuteQueuedCommands();
+
+	// Top level nodes/connections touched by the command being run, by id
+	// (nullptr once removed). Flushed to the journal and the save cache after
+	// every command.
+	UndoJournal _journal;
+	std::unordered_map<std::string, Node*> _changedNodes;
+	// Top level node of every group child (at any depth), so a changed child
+	// marks its root without searching the groups.
+	std::unordered_map<Node*, Node*> _rootNodes;
+	std::unordered_map<std::string, NodeConnection*> _changedConnections;
+	// Encoded JSON of the top level nodes/connections, shared with snapshots
+	// and only re-encoded once touched by a command.
+	EncodedChunks<Node> _encodedNodes;
+	EncodedChunks<NodeConnection> _encodedConnections;
+	uint64_t _changeVersion = 0;
+
+	uint64_t _contentHash = 0;
+	uint64_t _contentHashVersion = UINT64_MAX;
+	// As last loaded or saved, 0 after recovering changes that were never saved.
+	uint64_t _savedContentHash = 0;
+	uint64_t _savedChangeVersion = 0;
+	// Of the document last loaded or saved, the rest of it is compared by hash.
+	std::string _savedHeader;
+	int _savedScaleIndex = _defaultScaleIndex;
+	ImVec2 _savedOffset;
+
+	static std::string EncodeNode(Node* node);
+	static std::string EncodeConnection(NodeConnection* connection);
+	const EncodedChunkArray& PublishNodes();
+	const EncodedChunkArray& PublishConnections();
+	// TakeSnapshot without the header, which goes over every node (e.g. for copying a few of them).
+	GraphSnapshot TakeRecordsSnapshot();
+
+	Node* FindRootNode(Node* node);
+	void SetRootNode(_GroupNode* group, Node* root);
+	void ClearRootNode(_GroupNode* group);
+	void MarkNodeChanged(Node* node);
+	void FlushChanges();
+	void RebuildAnalyses();
 
 	ImGuiIO& _io = ImGui::GetIO();
 	ImDrawList* _drawList;
@@ -86,7 +308,8 @@ private:
 	};
 
 	int _scaleIndexClipDetails = 3;
-	int _scaleIndex = 7;
+	inline static const int _defaultScaleIndex = 7;
+	int _scaleIndex = _defaultScaleIndex;
 	float _scale = 1;
 	ImVec2 _scalePosition;
 	float _targetScale = 1;
@@ -95,23 +318,35 @@ private:
 	ImVec2 _windowSize;
 	ImVec2 _offset;
 
+	bool _hasPendingFocus = false;
+	ImVec2 _pendingFocusPosition;
+
 	ImColor _colorBackground = IM_COL32(200, 200, 200, 40);
 	float _backgroundGridSize = 48.0_dpi;
 	float _backgroundDotSize = 2_dpi;
 	void DrawBackground() const;
 
-	std::map<std::string, Node*> _nodes;
-	std::map<std::string, NodeConnection*> _connections;
+	SlotMap<Node*> _nodes;
+	SlotMap<NodeConnection*> _connections;
+
+	NodeLayout _layout;
+	std::vector<uint8_t> _offscreenSides;
+	std::vector<int> _selectionCandidates;
+
+	GraphReachability _reachability;
+	NodeKeyIndex _keyIndex;
+	SearchIndex _searchIndex;
+	SlotConnections _slotConnections;
+	ImColor _colorUnreachable = IM_COL32(255, 170, 0, 200);
 
 	std::unordered_set<Node*> _selectedNodes;
-	std::unordered_set<Node*> _copiedNodes;
-	CommandCluster* _copyNodesCommand;
+	std::unordered_map<Node*, _GroupNode*> _selectedChildNodes;
 
 	ImVec2 _draggedNodePos;
 	Node* _draggedNode;
 	Node* _hoveredNode;
 	Node* _focusedNode;
-	Node* _copiedNode;
+	Node* _currentNode = nullptr;
 	NodeSlot* _hoveredSlot;
 
 	std::string _validationMessage;
@@ -146,6 +381,14 @@ private:
 	ImColor _selectionFillColor = IM_COL32(60, 60, 60, 60);
 	ImColor _selectionOutlineColor = IM_COL32(120, 120, 120, 60);
 	ImVec2 _drawingSelectionFrom;
+	// The rectangle applied last frame, only nodes overlapping it or the new one can change.
+	bool _hasSelectionRect = false;
+	ImVec2 _selectionRectMin;
+	ImVec2 _selectionRectMax;
+	// Shift selects the children of group nodes instead of the nodes.
+	bool _isSelectingChildNodes = false;
+
+	std::string _templateName;
 
 	bool _isDrawingConnection = false;
 	NodeSlot* _drawingConnectionFrom = nullptr;
@@ -169,6 +412,18 @@ private:
 	inline ImVec2 CanvasToScreen(const ImVec2& canvasPos) const { return canvasPos * _scale + _offset + _windowPos; }
 
 	void DrawNodes();
+	void DrawUnreachableOutline(Node* node);
+	void BeginRectangleSelection();
+	void UpdateRectangleSelection();
+
+	void SetNodeSelected(Node* node, bool value);
+	void SetChildNodeSelected(_GroupNode* parent, Node* node, bool value);
+	void DeselectChildNodes(_GroupNode* parent);
+	void ClearSelection();
+	std::vector<Node*> GetSelection() const;
+	// Slots of the nodes and their group children.
+	void CollectSlots(const std::vector<Node*>& nodes, std::unordered_set<NodeSlot*>& slots) const;
+	void MoveNodesTo(const std::vector<Node*>& nodes, const std::vector<ImVec2>& positions, const char* label);
 
 	void DrawConnections();
 	void DrawContextMenus();
@@ -182,9 +437,9 @@ private:
 	void HandleInput();
 
 	inline static Node* CreateNode(const std::string& type) {
-		auto it = _nodesRegistry.find(type);
-		if (it != _nodesRegistry.end()) {
-			return it->second(ImVec2(0, 0));
+		auto it = _nodeTypeIds.find(type);
+		if (it != _nodeTypeIds.end()) {
+			return _nodeTypes[it->second].create(ImVec2(0, 0));
 		}
 
 		return nullptr;
@@ -199,7 +454,10 @@ private:
 	}
 
 	inline static std::unordered_map<std::type_index, std::function<void(Node*)>> _nodeContextMenus;
-	inline static std::unordered_map<std::string, std::function<Node* (ImVec2 pos)>> _nodesRegistry;
+	inline static std::vector<NodeType> _nodeTypes;
+	inline static std::unordered_map<std::string, int> _nodeTypeIds;
+	inline static TemplateLibrary _templates{ CreateNode };
+	inline static GraphProject _project;
 
 	struct Input {
 	private:
@@ -1,11 +1,22 @@
 #pragma once
 
+#include <cstddef>
+
 class NodesGraphSettings {
 private:
 	inline static float _dpiScale = 1.0f;
 	inline static bool _nodeSnappingEnabled = true;
 	inline static int _nodeSnapping = 5;
 	inline static bool _validateNodes = false;
+	inline static bool _highlightUnreachableNodes = false;
+
+	// Undo history budget, 0 means unlimited.
+	inline static int _historyMaxCommands = 0;
+	inline static int _historyMaxMegabytes = 256;
+
+	inline static bool _autosaveEnabled = true;
+	inline static int _autosaveInterval = 60;
+	inline static int _autosaveBackups = 3;
 
 public:
 	inline static float GetDpiScale() { return _dpiScale; }
@@ -19,4 +30,24 @@ public:
 
 	inline static bool ValidateNodes() { return _validateNodes; }
 	inline static bool& ValidateNodesRef() { return _validateNodes; }
+
+	inline static bool HighlightUnreachableNodes() { return _highlightUnreachableNodes; }
+	inline static bool& HighlightUnreachableNodesRef() { return _highlightUnreachableNodes; }
+
+	inline static int HistoryMaxCommands() { return _historyMaxCommands; }
+	inline static int& HistoryMaxCommandsRef() { return _historyMaxCommands; }
+
+	inline static int HistoryMaxMegabytes() { return _historyMaxMegabytes; }
+	inline static int& HistoryMaxMegabytesRef() { return _historyMaxMegabytes; }
+	inline static size_t HistoryMaxBytes() { return _historyMaxMegabytes > 0 ? (size_t)_historyMaxMegabytes << 20 : 0; }
+
+	inline static bool AutosaveEnabled() { return _autosaveEnabled; }
+	inline static bool& AutosaveEnabledRef() { return _autosaveEnabled; }
+
+	// Seconds between autosaves of the same graph.
+	inline static int AutosaveInterval() { return _autosaveInterval; }
+	inline static int& AutosaveIntervalRef() { return _autosaveInterval; }
+
+	inline static int AutosaveBackups() { return _autosaveBackups; }
+	inline static int& AutosaveBackupsRef() { return _autosaveBackups; }
 };
\ No newline at end of file
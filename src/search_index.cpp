@@ -0,0 +1,309 @@
+#include "search_index.h"
+
+// std
+#include <algorithm>
+#include <cctype>
+
+static const char FIELD_SEPARATOR = '\x1f';
+
+static std::string ToLower(const std::string& text)
+{
+	std::string result(text);
+	for (auto& c : result)
+		c = (char)std::tolower((unsigned char)c);
+
+	return result;
+}
+
+static void GetTrigrams(const std::string& text, std::vector<uint32_t>& trigrams)
+{
+	trigrams.clear();
+
+	for (size_t i = 0; i + 3 <= text.size(); i++)
+	{
+		auto c0 = (unsigned char)text[i];
+		auto c1 = (unsigned char)text[i + 1];
+		auto c2 = (unsigned char)text[i + 2];
+
+		if (c0 == FIELD_SEPARATOR || c1 == FIELD_SEPARATOR || c2 == FIELD_SEPARATOR)
+			continue;
+
+		trigrams.push_back((c0 << 16) | (c1 << 8) | c2);
+	}
+
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+SearchIndex::~SearchIndex()
+{
+	if (_building.valid())
+		_building.wait();
+}
+
+void SearchIndex::Clear()
+{
+	if (_building.valid())
+		_building.wait();
+
+	_building = {};
+	_data = {};
+	_pendingChanges.clear();
+	_version++;
+}
+
+void SearchIndex::Rebuild(SlotMap<Node*>& nodes)
+{
+	Clear();
+
+	// Reading the nodes has to happen here, only the indexing runs on the worker.
+	std::vector<PendingChange> changes;
+	changes.reserve(nodes.size());
+
+	auto collect = [&changes](Node* node) {
+		auto& change = changes.emplace_back();
+		change.node = node;
+		change.isRemoved = false;
+		node->GetSearchFields(change.fields);
+		};
+
+	for (const auto& [_, node] : nodes)
+	{
+		collect(node);
+
+		auto groupNode = node->AsGroup();
+		if (groupNode != nullptr)
+		{
+			for (const auto& child : groupNode->GetNodes())
+				collect(child);
+		}
+	}
+
+	_building = std::async(std::launch::async, &SearchIndex::Build, std::move(changes));
+}
+
+void SearchIndex::Sync()
+{
+	if (_building.valid() && _building.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+	{
+		_data = _building.get();
+
+		for (auto& change : _pendingChanges)
+			Apply(_data, change);
+
+		_pendingChanges.clear();
+		_version++;
+	}
+
+	// Edits leave dead documents behind in the posting lists, drop them once they dominate.
+	auto deadCount = _data.documents.size() - _data.nodeDocuments.size();
+	if (!_building.valid() && _data.documents.size() > 1024 && deadCount > _data.documents.size() / 2)
+		Compact();
+}
+
+void SearchIndex::Add(Node* node)
+{
+	Change(node, false);
+
+	auto groupNode = node->AsGroup();
+	if (groupNode != nullptr)
+	{
+		for (const auto& child : groupNode->GetNodes())
+			Change(child, false);
+	}
+}
+
+void SearchIndex::Remove(Node* node)
+{
+	Change(node, true);
+
+	auto groupNode = node->AsGroup();
+	if (groupNode != nullptr)
+	{
+		for (const auto& child : groupNode->GetNodes())
+			Change(child, true);
+	}
+}
+
+void SearchIndex::Update(Node* node)
+{
+	Change(node, false);
+}
+
+void SearchIndex::Search(const std::string& query, std::vector<SearchHit>& hits, size_t maxHits) const
+{
+	hits.clear();
+	if (query.empty())
+		return;
+
+	auto text = ToLower(query);
+
+	std::vector<uint32_t> candidates;
+	if (text.size() < 3)
+	{
+		for (const auto& [_, documentId] : _data.nodeDocuments)
+			candidates.push_back(documentId);
+
+		std::sort(candidates.begin(), candidates.end());
+	}
+	else
+	{
+		std::vector<uint32_t> trigrams;
+		GetTrigrams(text, trigrams);
+
+		std::vector<const std::vector<uint32_t>*> postings;
+		for (const auto& trigram : trigrams)
+		{
+			auto it = _data.postings.find(trigram);
+			if (it == _data.postings.end())
+				return;
+
+			postings.push_back(&it->second);
+		}
+
+		// Intersect starting from the shortest posting list.
+		std::sort(postings.begin(), postings.end(), [](auto a, auto b) { return a->size() < b->size(); });
+
+		candidates = *postings[0];
+		std::vector<uint32_t> intersection;
+
+		for (size_t i = 1; i < postings.size() && !candidates.empty(); i++)
+		{
+			intersection.clear();
+			std::set_intersection(candidates.begin(), candidates.end(), postings[i]->begin(), postings[i]->end(), std::back_inserter(intersection));
+			candidates.swap(intersection);
+		}
+	}
+
+	for (const auto& documentId : candidates)
+	{
+		const auto& document = _data.documents[documentId];
+		if (!document.isLive)
+			continue;
+
+		auto position = document.text.find(text);
+		if (position == std::string::npos)
+			continue;
+
+		auto separator = document.text.rfind(FIELD_SEPARATOR, position);
+		auto fieldStart = separator == std::string::npos ? 0 : separator + 1;
+		auto fieldIndex = std::count(document.text.begin(), document.text.begin() + position, FIELD_SEPARATOR);
+
+		const auto& field = document.fields[fieldIndex];
+		auto positionInField = position - fieldStart;
+
+		// Prefer matches at the start of a field, then at a word start, then shorter fields.
+		float score = positionInField == 0 ? 3.0f : !std::isalnum((unsigned char)document.text[position - 1]) ? 2.0f : 1.0f;
+		score += (float)text.size() / (float)field.size();
+
+		hits.push_back({ document.node, field, positionInField, score });
+	}
+
+	auto compare = [](const SearchHit& a, const SearchHit& b) { return a.score > b.score; };
+
+	if (hits.size() > maxHits)
+	{
+		std::partial_sort(hits.begin(), hits.begin() + maxHits, hits.end(), compare);
+		hits.resize(maxHits);
+	}
+	else
+	{
+		std::stable_sort(hits.begin(), hits.end(), compare);
+	}
+}
+
+SearchIndex::Data SearchIndex::Build(std::vector<PendingChange> changes)
+{
+	Data data;
+	data.documents.reserve(changes.size());
+	data.nodeDocuments.reserve(changes.size());
+
+	for (auto& change : changes)
+		AddDocument(data, change.node, change.fields);
+
+	return data;
+}
+
+void SearchIndex::Apply(Data& data, PendingChange& change)
+{
+	RemoveDocument(data, change.node);
+
+	if (!change.isRemoved)
+		AddDocument(data, change.node, change.fields);
+}
+
+void SearchIndex::AddDocument(Data& data, Node* node, std::vector<std::string>& fields)
+{
+	if (fields.empty())
+		return;
+
+	auto documentId = (uint32_t)data.documents.size();
+	auto& document = data.documents.emplace_back();
+	document.node = node;
+	document.fields = fields;
+	document.isLive = true;
+
+	for (const auto& field : fields)
+	{
+		if (!document.text.empty())
+			document.text += FIELD_SEPARATOR;
+
+		document.text += ToLower(field);
+	}
+
+	// Document ids only grow, so the posting lists stay sorted.
+	std::vector<uint32_t> trigrams;
+	GetTrigrams(document.text, trigrams);
+
+	for (const auto& trigram : trigrams)
+		data.postings[trigram].push_back(documentId);
+
+	data.nodeDocuments[node] = documentId;
+}
+
+void SearchIndex::RemoveDocument(Data& data, Node* node)
+{
+	auto it = data.nodeDocuments.find(node);
+	if (it == data.nodeDocuments.end())
+		return;
+
+	// The id stays in the posting lists until the next compaction, searches skip it.
+	auto& document = data.documents[it->second];
+	document.isLive = false;
+	document.fields = {};
+	document.text = {};
+
+	data.nodeDocuments.erase(it);
+}
+
+void SearchIndex::Change(Node* node, bool isRemoved)
+{
+	PendingChange change;
+	change.node = node;
+	change.isRemoved = isRemoved;
+
+	if (!isRemoved)
+		node->GetSearchFields(change.fields);
+
+	// Keep the current index searchable while a build is running, and replay
+	// the change on top of the build result once it arrives.
+	if (_building.valid())
+		_pendingChanges.push_back(change);
+
+	Apply(_data, change);
+	_version++;
+}
+
+void SearchIndex::Compact()
+{
+	std::vector<PendingChange> changes;
+	changes.reserve(_data.nodeDocuments.size());
+
+	for (const auto& document : _data.documents)
+	{
+		if (document.isLive)
+			changes.push_back({ document.node, document.fields, false });
+	}
+
+	_building = std::async(std::launch::async, &SearchIndex::Build, std::move(changes));
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <future>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// local
+#include "node.h"
+#include "slot_map.h"
+
+struct SearchHit {
+	Node* node;
+	std::string field;
+	size_t position;
+	float score;
+};
+
+// Case-insensitive substring search over the fields nodes expose through
+// Node::_GetSearchFields. Documents are indexed by their trigrams; a query
+// intersects the posting lists of its trigrams and only verifies those
+// candidates. The initial index is built on a worker thread.
+class SearchIndex {
+public:
+	~SearchIndex();
+
+	void Clear();
+	void Rebuild(SlotMap<Node*>& nodes);
+
+	// Picks up the result of a background build, must be called on the UI thread.
+	void Sync();
+	inline bool IsBuilding() const { return _building.valid(); }
+
+	// Add/Remove include the children of group nodes, Update only re-reads the given node.
+	void Add(Node* node);
+	void Remove(Node* node);
+	void Update(Node* node);
+
+	void Search(const std::string& query, std::vector<SearchHit>& hits, size_t maxHits = 100) const;
+
+	inline size_t GetDocumentCount() const { return _data.nodeDocuments.size(); }
+
+	// Changes whenever the indexed content changes, hits from an older version may be stale.
+	inline uint64_t GetVersion() const { return _version; }
+
+private:
+	struct Document {
+		Node* node;
+		std::vector<std::string> fields;
+		std::string text;
+		bool isLive;
+	};
+
+	struct Data {
+		std::vector<Document> documents;
+		std::unordered_map<uint32_t, std::vector<uint32_t>> postings;
+		std::unordered_map<Node*, uint32_t> nodeDocuments;
+	};
+
+	struct PendingChange {
+		Node* node;
+		std::vector<std::string> fields;
+		bool isRemoved;
+	};
+
+	Data _data;
+	uint64_t _version = 0;
+
+	std::future<Data> _building;
+	std::vector<PendingChange> _pendingChanges;
+
+	static Data Build(std::vector<PendingChange> changes);
+	static void Apply(Data& data, PendingChange& change);
+	static void AddDocument(Data& data, Node* node, std::vector<std::string>& fields);
+	static void RemoveDocument(Data& data, Node* node);
+
+	void Change(Node* node, bool isRemoved);
+	void Compact();
+};
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include "slot_connections.h"
+
+// std
+#include <algorithm>
+
+void SlotConnections::Clear()
+{
+	_connections.clear();
+}
+
+void SlotConnections::Rebuild(SlotMap<NodeConnection*>& connections)
+{
+	Clear();
+	_connections.reserve(connections.size() * 2);
+
+	for (const auto& [_, connection] : connections)
+		Add(connection);
+}
+
+void SlotConnections::Add(NodeConnection* connection)
+{
+	_connections[connection->GetFrom()].push_back(connection);
+	if (connection->GetTo() != connection->GetFrom())
+		_connections[connection->GetTo()].push_back(connection);
+}
+
+void SlotConnections::Remove(NodeConnection* connection)
+{
+	Unlink(connection->GetFrom(), connection);
+	if (connection->GetTo() != connection->GetFrom())
+		Unlink(connection->GetTo(), connection);
+}
+
+const std::vector<NodeConnection*>& SlotConnections::Get(NodeSlot* slot) const
+{
+	auto it = _connections.find(slot);
+	return it != _connections.end() ? it->second : _empty;
+}
+
+void SlotConnections::Collect(Node* node, std::vector<NodeConnection*>& connections) const
+{
+	auto first = connections.size();
+
+	for (auto slot : node->GetSlots()) {
+		auto& slotConnections = Get(slot);
+		connections.insert(connections.end(), slotConnections.begin(), slotConnections.end());
+	}
+
+	auto groupNode = node->AsGroup();
+	if (groupNode != nullptr) {
+		for (auto child : groupNode->GetNodes())
+			Collect(child, connections);
+	}
+
+	// Connections between two slots of the node were added from both ends.
+	std::sort(connections.begin() + first, connections.end());
+	connections.erase(std::unique(connections.begin() + first, connections.end()), connections.end());
+}
+
+void SlotConnections::Unlink(NodeSlot* slot, NodeConnection* connection)
+{
+	auto it = _connections.find(slot);
+	if (it == _connections.end())
+		return;
+
+	auto& slotConnections = it->second;
+	auto position = std::find(slotConnections.begin(), slotConnections.end(), connection);
+	if (position != slotConnections.end()) {
+		*position = slotConnections.back();
+		slotConnections.pop_back();
+	}
+
+	if (slotConnections.empty())
+		_connections.erase(it);
+}
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+// std
+#include <unordered_map>
+#include <vector>
+
+// local
+#include "node.h"
+#include "node_connection.h"
+#include "slot_map.h"
+
+// Connections by the slots at either of their ends, so the connections of a
+// node are found without scanning all connections of the graph.
+class SlotConnections {
+public:
+	void Clear();
+	void Rebuild(SlotMap<NodeConnection*>& connections);
+
+	void Add(NodeConnection* connection);
+	void Remove(NodeConnection* connection);
+
+	const std::vector<NodeConnection*>& Get(NodeSlot* slot) const;
+	// Appends the connections attached to the node or its group children, each once.
+	void Collect(Node* node, std::vector<NodeConnection*>& connections) const;
+
+private:
+	std::unordered_map<NodeSlot*, std::vector<NodeConnection*>> _connections;
+
+	inline static const std::vector<NodeConnection*> _empty;
+
+	void Unlink(NodeSlot* slot, NodeConnection* connection);
+};
\ No newline at end of file
@@ -0,0 +1,161 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Stable reference to an element of a SlotMap. Lookups with it fail once the
+// element is erased, even if its slot has been reused since.
+struct SlotHandle {
+	uint32_t index = UINT32_MAX;
+	uint32_t generation = 0;
+
+	inline bool IsValid() const { return index != UINT32_MAX; }
+	inline bool operator==(const SlotHandle& other) const = default;
+};
+
+// Id keyed storage for graph elements. Elements are packed in one array
+// (erasing moves the last element into the gap), so iteration is linear
+// and insert/erase are O(1). Dense positions change on erase, handles don't.
+//
+// Iterates (id, value) pairs in no particular order, with the subset of the
+// std::map interface the graph used before.
+template<typename T>
+class SlotMap {
+public:
+	using value_type = std::pair<std::string, T>;
+	using iterator = typename std::vector<value_type>::iterator;
+	using const_iterator = typename std::vector<value_type>::const_iterator;
+
+	void reserve(size_t count) {
+		_values.reserve(count);
+		_valueSlots.reserve(count);
+		_slots.reserve(count);
+		_ids.reserve(count);
+	}
+
+	void clear() {
+		// Slots are freed one by one so handles to the old elements stay invalid.
+		for (auto slotIndex : _valueSlots)
+			FreeSlot(slotIndex);
+
+		_values.clear();
+		_valueSlots.clear();
+		_ids.clear();
+	}
+
+	inline size_t size() const { return _values.size(); }
+	inline bool empty() const { return _values.empty(); }
+
+	inline iterator begin() { return _values.begin(); }
+	inline iterator end() { return _values.end(); }
+	inline const_iterator begin() const { return _values.begin(); }
+	inline const_iterator end() const { return _values.end(); }
+
+	// Keeps the existing element if the id is taken, like std::map::emplace.
+	std::pair<iterator, bool> emplace(const std::string& id, T value) {
+		auto it = _ids.find(id);
+		if (it != _ids.end())
+			return { begin() + _slots[it->second].value, false };
+
+		auto slotIndex = AllocateSlot();
+		_slots[slotIndex].value = (uint32_t)_values.size();
+
+		_values.emplace_back(id, std::move(value));
+		_valueSlots.push_back(slotIndex);
+		_ids.emplace(id, slotIndex);
+
+		return { end() - 1, true };
+	}
+
+	T& operator[](const std::string& id) {
+		return emplace(id, T()).first->second;
+	}
+
+	size_t erase(const std::string& id) {
+		auto it = _ids.find(id);
+		if (it == _ids.end())
+			return 0;
+
+		auto slotIndex = it->second;
+		auto valueIndex = _slots[slotIndex].value;
+		auto lastIndex = (uint32_t)_values.size() - 1;
+
+		if (valueIndex != lastIndex) {
+			_values[valueIndex] = std::move(_values[lastIndex]);
+			_valueSlots[valueIndex] = _valueSlots[lastIndex];
+			_slots[_valueSlots[valueIndex]].value = valueIndex;
+		}
+
+		_values.pop_back();
+		_valueSlots.pop_back();
+		_ids.erase(it);
+
+		FreeSlot(slotIndex);
+		return 1;
+	}
+
+	iterator find(const std::string& id) {
+		auto it = _ids.find(id);
+		return it != _ids.end() ? begin() + _slots[it->second].value : end();
+	}
+
+	const_iterator find(const std::string& id) const {
+		auto it = _ids.find(id);
+		return it != _ids.end() ? begin() + _slots[it->second].value : end();
+	}
+
+	inline bool contains(const std::string& id) const {
+		return _ids.contains(id);
+	}
+
+	SlotHandle GetHandle(const std::string& id) const {
+		auto it = _ids.find(id);
+		if (it == _ids.end())
+			return SlotHandle();
+
+		return { it->second, _slots[it->second].generation };
+	}
+
+	// Returns a default constructed value (nullptr) for erased elements.
+	T Get(SlotHandle handle) const {
+		if (handle.index >= _slots.size() || _slots[handle.index].generation != handle.generation)
+			return T();
+
+		return _values[_slots[handle.index].value].second;
+	}
+
+private:
+	struct Slot {
+		// Dense index of the element, or the next free slot while free.
+		uint32_t value;
+		uint32_t generation;
+	};
+
+	std::vector<value_type> _values;
+	std::vector<uint32_t> _valueSlots;
+	std::vector<Slot> _slots;
+	uint32_t _freeSlot = UINT32_MAX;
+
+	std::unordered_map<std::string, uint32_t> _ids;
+
+	uint32_t AllocateSlot() {
+		if (_freeSlot == UINT32_MAX) {
+			_slots.push_back({ 0, 0 });
+			return (uint32_t)_slots.size() - 1;
+		}
+
+		auto slotIndex = _freeSlot;
+		_freeSlot = _slots[slotIndex].value;
+		return slotIndex;
+	}
+
+	void FreeSlot(uint32_t slotIndex) {
+		_slots[slotIndex].generation++;
+		_slots[slotIndex].value = _freeSlot;
+		_freeSlot = slotIndex;
+	}
+};
\ No newline at end of file
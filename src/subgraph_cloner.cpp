@@ -0,0 +1,46 @@
+#include "subgraph_cloner.h"
+
+static void MapSlots(Node* node, Node* clone, std::unordered_map<NodeSlot*, NodeSlot*>& slots)
+{
+	auto& nodeSlots = node->GetSlots();
+	auto& cloneSlots = clone->GetSlots();
+	for (size_t i = 0; i < nodeSlots.size() && i < cloneSlots.size(); i++)
+		slots.emplace(nodeSlots[i], cloneSlots[i]);
+
+	auto groupNode = node->AsGroup();
+	auto groupClone = clone->AsGroup();
+	if (groupNode != nullptr && groupClone != nullptr) {
+		auto& children = groupNode->GetNodes();
+		auto& childClones = groupClone->GetNodes();
+		for (size_t i = 0; i < children.size() && i < childClones.size(); i++)
+			MapSlots(children[i], childClones[i], slots);
+	}
+}
+
+void SubgraphCloner::Clone(const std::vector<Node*>& nodes, const SlotConnections& slotConnections,
+	std::vector<Node*>& clonedNodes, std::vector<NodeConnection*>& clonedConnections,
+	std::unordered_map<NodeSlot*, NodeSlot*>* slotMap)
+{
+	std::unordered_map<NodeSlot*, NodeSlot*> localSlots;
+	auto& slots = slotMap != nullptr ? *slotMap : localSlots;
+	slots.reserve(nodes.size() * 2);
+	clonedNodes.reserve(clonedNodes.size() + nodes.size());
+
+	for (auto node : nodes) {
+		auto clone = node->Clone();
+		clonedNodes.push_back(clone);
+		MapSlots(node, clone, slots);
+	}
+
+	// Each internal connection is found from both of its slots, it is cloned from the one it starts at.
+	for (const auto& [slot, slotClone] : slots) {
+		for (auto connection : slotConnections.Get(slot)) {
+			if (connection->GetFrom() != slot)
+				continue;
+
+			auto to = slots.find(connection->GetTo());
+			if (to != slots.end())
+				clonedConnections.push_back(connection->Clone(slotClone, to->second));
+		}
+	}
+}
\ No newline at end of file
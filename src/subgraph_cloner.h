@@ -0,0 +1,23 @@
+#pragma once
+
+// std
+#include <unordered_map>
+#include <vector>
+
+// local
+#include "node.h"
+#include "node_connection.h"
+#include "slot_connections.h"
+
+// Clones a set of nodes (group children included) together with the
+// connections between them, for duplicating and instancing parts of a graph.
+class SubgraphCloner {
+public:
+	// O(nodes + connections attached to them): clone slots are matched to the
+	// original ones by index, connections are found through `slotConnections`.
+	// Clones keep the positions of the originals and are not added to any graph.
+	// `clonedNodes[i]` is the clone of `nodes[i]`, `slotMap` receives the clone of every slot.
+	static void Clone(const std::vector<Node*>& nodes, const SlotConnections& slotConnections,
+		std::vector<Node*>& clonedNodes, std::vector<NodeConnection*>& clonedConnections,
+		std::unordered_map<NodeSlot*, NodeSlot*>* slotMap = nullptr);
+};
\ No newline at end of file
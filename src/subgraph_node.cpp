@@ -0,0 +1,290 @@
+#include "subgraph_node.h"
+
+// std
+#include <unordered_map>
+
+SubgraphNode::~SubgraphNode()
+{
+	delete _graph;
+}
+
+void SubgraphNode::_Init()
+{
+	_colorOutline = ImColor(90, 160, 220);
+}
+
+void SubgraphNode::_Draw(ImDrawList* drawList)
+{
+	ImGui::TextDisabled("%d nodes, %d connections", (int)_contents.nodeCount, (int)_contents.connectionCount);
+
+	if (ImGui::SmallButton(_isExpanded ? "Hide" : "Show"))
+		SetExpanded(!_isExpanded);
+
+	ImGui::SameLine();
+	if (ImGui::SmallButton("Enter") && NodesGraph::GetCurrent() != nullptr)
+		NodesGraph::GetCurrent()->EnterSubgraph(this);
+
+	if (_isExpanded)
+		DrawPreview(drawList);
+}
+
+void SubgraphNode::_ToJson(nlohmann::json& j)
+{
+	nlohmann::json jsonPorts = nlohmann::json::array();
+	for (const auto& port : _ports)
+		jsonPorts.push_back({ { "slot", port.slot }, { "input", port.isInput } });
+
+	j["ports"] = jsonPorts;
+	j["node_count"] = _contents.nodeCount;
+	j["connection_count"] = _contents.connectionCount;
+	j["expanded"] = _isExpanded;
+
+	if (_contents.data.empty())
+		return;
+
+	if (_parsedContents.is_null())
+		_parsedContents = nlohmann::json::parse(_contents.data, nullptr, false);
+
+	j["graph"] = _parsedContents;
+}
+
+void SubgraphNode::_FromJson(const nlohmann::json& j)
+{
+	Unload();
+
+	_contents.nodeCount = j.value("node_count", (size_t)0);
+	_contents.connectionCount = j.value("connection_count", (size_t)0);
+	_contents.data = j.contains("graph") ? j["graph"].dump() : std::string();
+	_parsedContents = nlohmann::json();
+	_isExpanded = j.value("expanded", false);
+}
+
+void SubgraphNode::FromJson(const nlohmann::json& j)
+{
+	if (GetSlots().empty() && j.contains("ports"))
+	{
+		std::vector<SubgraphPort> ports;
+		for (const auto& jsonPort : j["ports"])
+			ports.push_back({ jsonPort.at("slot").get<std::string>(), jsonPort.value("input", true) });
+
+		SetPorts(ports);
+	}
+
+	Node::FromJson(j);
+}
+
+Node* SubgraphNode::_Clone()
+{
+	auto clone = new SubgraphNode();
+	clone->_contents = _contents;
+	clone->_isExpanded = _isExpanded;
+	clone->SetPorts(_ports);
+	return clone;
+}
+
+size_t SubgraphNode::_GetMemoryUsage() const
+{
+	auto usage = sizeof(SubgraphNode) + _contents.data.capacity();
+	// Roughly, the parsed contents take more than their text.
+	if (!_parsedContents.is_null())
+		usage += _contents.data.size() * 2;
+	usage += _ports.capacity() * sizeof(SubgraphPort);
+	usage += (_previewRects.capacity() + _previewLines.capacity()) * sizeof(ImVec4);
+
+	if (_graph != nullptr)
+	{
+		for (const auto& [_, node] : _graph->GetNodes())
+			usage += node->GetMemoryUsage();
+
+		usage += _graph->GetConnections().size() * sizeof(NodeConnection);
+	}
+
+	return usage;
+}
+
+void SubgraphNode::SetPorts(const std::vector<SubgraphPort>& ports)
+{
+	if (!GetSlots().empty())
+		return;
+
+	int inputCount = 0;
+	int outputCount = 0;
+	for (const auto& port : ports)
+		(port.isInput ? inputCount : outputCount)++;
+
+	// Inputs spread along the left side, outputs along the right.
+	int input = 0;
+	int output = 0;
+	for (const auto& port : ports)
+	{
+		if (port.isInput)
+			AddSlot(ImVec2(0, (float)++input / (inputCount + 1)), true, false);
+		else
+			AddSlot(ImVec2(1, (float)++output / (outputCount + 1)), false, true);
+	}
+
+	_ports = ports;
+}
+
+void SubgraphNode::ResolvePorts(std::vector<NodeSlot*>& slots)
+{
+	slots.assign(_ports.size(), nullptr);
+
+	auto graph = GetGraph();
+	if (graph == nullptr || _ports.empty())
+		return;
+
+	std::unordered_map<std::string, size_t> ports;
+	for (size_t i = 0; i < _ports.size(); i++)
+		ports.emplace(_ports[i].slot, i);
+
+	auto resolve = [&](Node* node) {
+		for (auto slot : node->GetSlots())
+		{
+			auto it = ports.find(slot->GetId());
+			if (it == ports.end())
+				continue;
+
+			// A slot can be both an input and an output port.
+			for (size_t i = it->second; i < _ports.size(); i++)
+			{
+				if (_ports[i].slot == slot->GetId())
+					slots[i] = slot;
+			}
+		}
+		};
+
+	for (const auto& [_, node] : graph->GetNodes())
+	{
+		resolve(node);
+
+		auto groupNode = node->AsGroup();
+		if (groupNode != nullptr)
+		{
+			for (auto child : groupNode->GetNodes())
+				resolve(child);
+		}
+	}
+}
+
+void SubgraphNode::SetContents(const SubgraphContents& contents, bool isFromGraph)
+{
+	if (!isFromGraph)
+		Unload();
+
+	_contents = contents;
+	_parsedContents = nlohmann::json();
+}
+
+NodesGraph* SubgraphNode::GetGraph()
+{
+	if (_graph == nullptr)
+	{
+		_graph = new NodesGraph();
+		if (!_contents.data.empty())
+			_graph->Deserialize(_contents.data);
+	}
+
+	return _graph;
+}
+
+void SubgraphNode::Unload()
+{
+	delete _graph;
+	_graph = nullptr;
+
+	_previewRects.clear();
+	_previewRects.shrink_to_fit();
+	_previewLines.clear();
+	_previewLines.shrink_to_fit();
+	_previewVersion = UINT64_MAX;
+}
+
+void SubgraphNode::SetExpanded(bool value)
+{
+	_isExpanded = value;
+	if (!_isExpanded && !_isEntered)
+		Unload();
+}
+
+void SubgraphNode::SetEntered(bool value)
+{
+	_isEntered = value;
+	if (!_isExpanded && !_isEntered)
+		Unload();
+}
+
+void SubgraphNode::BuildPreview()
+{
+	auto graph = GetGraph();
+
+	_previewRects.clear();
+	_previewLines.clear();
+	_previewVersion = graph->GetChangeVersion();
+
+	if (graph->GetNodes().empty())
+		return;
+
+	ImVec2 boundsMin(FLT_MAX, FLT_MAX);
+	ImVec2 boundsMax(-FLT_MAX, -FLT_MAX);
+	for (const auto& [_, node] : graph->GetNodes())
+	{
+		boundsMin = ImMin(boundsMin, node->GetPosition());
+		boundsMax = ImMax(boundsMax, node->GetPosition() + node->GetSize());
+	}
+
+	auto boundsSize = ImMax(boundsMax - boundsMin, ImVec2(1, 1));
+	auto scale = ImMin(_previewSize.x / boundsSize.x, _previewSize.y / boundsSize.y);
+	auto toPreview = [&](ImVec2 position) { return (position - boundsMin) * scale; };
+
+	// Connections are drawn between the centers of the top level nodes.
+	std::unordered_map<NodeSlot*, ImVec2> centers;
+	_previewRects.reserve(graph->GetNodes().size());
+
+	for (const auto& [_, node] : graph->GetNodes())
+	{
+		auto min = toPreview(node->GetPosition());
+		auto max = toPreview(node->GetPosition() + node->GetSize());
+		_previewRects.emplace_back(min.x, min.y, max.x, max.y);
+
+		auto center = (min + max) * 0.5f;
+		for (auto slot : node->GetSlots())
+			centers[slot] = center;
+
+		auto groupNode = node->AsGroup();
+		if (groupNode != nullptr)
+		{
+			for (auto child : groupNode->GetNodes())
+			{
+				for (auto slot : child->GetSlots())
+					centers[slot] = center;
+			}
+		}
+	}
+
+	_previewLines.reserve(graph->GetConnections().size());
+	for (const auto& [_, connection] : graph->GetConnections())
+	{
+		auto from = centers.find(connection->GetFrom());
+		auto to = centers.find(connection->GetTo());
+		if (from != centers.end() && to != centers.end())
+			_previewLines.emplace_back(from->second.x, from->second.y, to->second.x, to->second.y);
+	}
+}
+
+void SubgraphNode::DrawPreview(ImDrawList* drawList)
+{
+	if (_graph == nullptr || _graph->GetChangeVersion() != _previewVersion)
+		BuildPreview();
+
+	ImGui::Dummy(_previewSize);
+	auto origin = ImGui::GetItemRectMin();
+
+	drawList->AddRectFilled(origin, origin + _previewSize, IM_COL32(0, 0, 0, 60));
+
+	for (const auto& line : _previewLines)
+		drawList->AddLine(origin + ImVec2(line.x, line.y), origin + ImVec2(line.z, line.w), IM_COL32(150, 150, 150, 120));
+
+	for (const auto& rect : _previewRects)
+		drawList->AddRectFilled(origin + ImVec2(rect.x, rect.y), origin + ImVec2(rect.z, rect.w), IM_COL32(90, 160, 220, 160));
+}
\ No newline at end of file
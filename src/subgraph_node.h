@@ -0,0 +1,85 @@
+#pragma once
+
+// std
+#include <string>
+#include <vector>
+
+// local
+#include "node.h"
+#include "nodes_graph.h"
+
+// A slot of the subgraph node standing in for a slot of the inner graph.
+struct SubgraphPort {
+	std::string slot;
+	bool isInput;
+};
+
+// What the node saves of its inner graph, the graph itself only exists while loaded.
+struct SubgraphContents {
+	std::string data;
+	size_t nodeCount = 0;
+	size_t connectionCount = 0;
+};
+
+// A whole NodesGraph collapsed into one node. The inner graph is kept encoded
+// (as NodesGraph::Serialize writes it) and only loaded while the node shows
+// its preview or is entered (see NodesGraph::EnterSubgraph).
+//
+// The node's slots are its ports, in the same order; each maps to the inner
+// slot with the port's id, connections to it continue there.
+class SubgraphNode : public Node {
+private:
+	SubgraphContents _contents;
+	// The contents parsed the first time the node is encoded, so moving or
+	// editing the node doesn't parse the whole inner graph again each time.
+	nlohmann::json _parsedContents;
+	std::vector<SubgraphPort> _ports;
+	NodesGraph* _graph = nullptr;
+
+	bool _isExpanded = false;
+	bool _isEntered = false;
+
+	// Rectangles and lines of the inner graph scaled into the preview, rebuilt when it changes.
+	std::vector<ImVec4> _previewRects;
+	std::vector<ImVec4> _previewLines;
+	uint64_t _previewVersion = UINT64_MAX;
+	ImVec2 _previewSize = ImVec2(240_dpi, 160_dpi);
+
+	void BuildPreview();
+	void DrawPreview(ImDrawList* drawList);
+
+	void _Init() override;
+	void _Draw(ImDrawList* drawList) override;
+	void _ToJson(nlohmann::json& j) override;
+	void _FromJson(const nlohmann::json& j) override;
+	Node* _Clone() override;
+	size_t _GetMemoryUsage() const override;
+
+public:
+	inline static constexpr const char* TypeName = "Subgraph";
+
+	~SubgraphNode() override;
+
+	// Ports decide the slots, they are read before Node reads the slots.
+	void FromJson(const nlohmann::json& j) override;
+
+	inline const std::vector<SubgraphPort>& GetPorts() const { return _ports; }
+	// Only for a node without slots, each port adds one.
+	void SetPorts(const std::vector<SubgraphPort>& ports);
+	// The inner slot of every port, nullptr where the inner graph no longer has it. Loads the graph.
+	void ResolvePorts(std::vector<NodeSlot*>& slots);
+
+	inline const SubgraphContents& GetContents() const { return _contents; }
+	// Unloads the inner graph, unless the contents were just taken from it.
+	void SetContents(const SubgraphContents& contents, bool isFromGraph = false);
+
+	// Loads the inner graph on first use.
+	NodesGraph* GetGraph();
+	inline NodesGraph* GetLoadedGraph() const { return _graph; }
+	void Unload();
+
+	inline bool IsExpanded() const { return _isExpanded; }
+	void SetExpanded(bool value);
+	inline bool IsEntered() const { return _isEntered; }
+	void SetEntered(bool value);
+};
\ No newline at end of file
@@ -0,0 +1,237 @@
+#include "undo_journal.h"
+
+// std
+#include <sstream>
+#include <unordered_map>
+
+UndoJournal::~UndoJournal()
+{
+	Close();
+}
+
+bool UndoJournal::Open(const std::string& path)
+{
+	Close();
+
+	_file = std::fopen(path.c_str(), "ab");
+	if (_file == nullptr)
+		return false;
+
+	_path = path;
+	_stop = false;
+	_truncate = false;
+	_thread = std::thread(&UndoJournal::Run, this);
+
+	return true;
+}
+
+void UndoJournal::Close(bool discard)
+{
+	if (!_thread.joinable())
+		return;
+
+	{
+		std::lock_guard lock(_mutex);
+		_stop = true;
+		if (discard)
+			_pending.clear();
+	}
+
+	_condition.notify_one();
+	_thread.join();
+
+	// Nothing to recover from an empty journal either.
+	bool isEmpty = true;
+	if (_file != nullptr) {
+		std::fseek(_file, 0, SEEK_END);
+		isEmpty = std::ftell(_file) == 0;
+		std::fclose(_file);
+		_file = nullptr;
+	}
+
+	if (discard || isEmpty)
+		std::remove(_path.c_str());
+
+	_path.clear();
+}
+
+void UndoJournal::AppendNode(const std::string& id, nlohmann::json&& data)
+{
+	Append({ { "op", "node" }, { "id", id }, { "data", std::move(data) } });
+}
+
+void UndoJournal::AppendNodeRemoved(const std::string& id)
+{
+	Append({ { "op", "node_removed" }, { "id", id } });
+}
+
+void UndoJournal::AppendConnection(const std::string& id, nlohmann::json&& data)
+{
+	Append({ { "op", "connection" }, { "id", id }, { "data", std::move(data) } });
+}
+
+void UndoJournal::AppendConnectionRemoved(const std::string& id)
+{
+	Append({ { "op", "connection_removed" }, { "id", id } });
+}
+
+void UndoJournal::Checkpoint()
+{
+	if (!IsOpen())
+		return;
+
+	std::lock_guard lock(_mutex);
+	_pending.clear();
+	_truncate = true;
+}
+
+void UndoJournal::Append(nlohmann::json&& record)
+{
+	if (!IsOpen())
+		return;
+
+	std::lock_guard lock(_mutex);
+	_pending.emplace_back(std::move(record));
+}
+
+void UndoJournal::Run()
+{
+	std::vector<nlohmann::json> batch;
+	std::string buffer;
+
+	while (true)
+	{
+		bool truncate;
+		bool stop;
+
+		{
+			std::unique_lock lock(_mutex);
+			_condition.wait_for(lock, BatchInterval, [this] { return _stop; });
+
+			batch.swap(_pending);
+			truncate = _truncate;
+			stop = _stop;
+			_truncate = false;
+		}
+
+		if (truncate)
+			_file = std::freopen(_path.c_str(), "wb", _file);
+
+		if (_file != nullptr && !batch.empty())
+		{
+			buffer.clear();
+			for (const auto& record : batch)
+			{
+				buffer += record.dump();
+				buffer += '\n';
+			}
+
+			std::fwrite(buffer.data(), 1, buffer.size(), _file);
+			std::fflush(_file);
+		}
+		else if (_file != nullptr && truncate)
+			std::fflush(_file);
+
+		batch.clear();
+
+		if (stop)
+			break;
+	}
+}
+
+std::string UndoJournal::Replay(const std::string& graphData, const std::string& journalData, size_t* recordCount)
+{
+	using json = nlohmann::json;
+
+	// Graphs that were never saved are empty files.
+	auto graph = graphData.empty() ? json::object() : json::parse(graphData);
+
+	// Keep the saved order, removed entries are left as null and dropped at the end.
+	std::vector<json> nodes;
+	std::vector<json> connections;
+	std::unordered_map<std::string, size_t> nodeIndices;
+	std::unordered_map<std::string, size_t> connectionIndices;
+
+	for (auto& node : graph.value("nodes", json::array()))
+	{
+		nodeIndices[node["id"].get<std::string>()] = nodes.size();
+		nodes.emplace_back(std::move(node));
+	}
+
+	for (auto& connection : graph.value("connections", json::array()))
+	{
+		connectionIndices[connection["id"].get<std::string>()] = connections.size();
+		connections.emplace_back(std::move(connection));
+	}
+
+	auto set = [](std::vector<json>& values, std::unordered_map<std::string, size_t>& indices, const std::string& id, json& data) {
+		auto it = indices.find(id);
+		if (it != indices.end())
+			values[it->second] = std::move(data);
+		else {
+			indices[id] = values.size();
+			values.emplace_back(std::move(data));
+		}
+	};
+
+	auto remove = [](std::vector<json>& values, std::unordered_map<std::string, size_t>& indices, const std::string& id) {
+		auto it = indices.find(id);
+		if (it == indices.end())
+			return;
+
+		values[it->second] = nullptr;
+		indices.erase(it);
+	};
+
+	size_t count = 0;
+	std::istringstream stream(journalData);
+	std::string line;
+
+	while (std::getline(stream, line))
+	{
+		if (line.empty())
+			continue;
+
+		auto record = json::parse(line, nullptr, false);
+		if (record.is_discarded() || !record.contains("op") || !record.contains("id"))
+			break;
+
+		auto op = record["op"].get<std::string>();
+		auto id = record["id"].get<std::string>();
+
+		if (op == "node")
+			set(nodes, nodeIndices, id, record["data"]);
+		else if (op == "node_removed")
+			remove(nodes, nodeIndices, id);
+		else if (op == "connection")
+			set(connections, connectionIndices, id, record["data"]);
+		else if (op == "connection_removed")
+			remove(connections, connectionIndices, id);
+		else
+			break;
+
+		count++;
+	}
+
+	json jsonArrayNodes = json::array();
+	for (auto& node : nodes)
+	{
+		if (!node.is_null())
+			jsonArrayNodes.push_back(std::move(node));
+	}
+
+	json jsonArrayConnections = json::array();
+	for (auto& connection : connections)
+	{
+		if (!connection.is_null())
+			jsonArrayConnections.push_back(std::move(connection));
+	}
+
+	graph["nodes"] = std::move(jsonArrayNodes);
+	graph["connections"] = std::move(jsonArrayConnections);
+
+	if (recordCount != nullptr)
+		*recordCount = count;
+
+	return graph.dump();
+}
\ No newline at end of file
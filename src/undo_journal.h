@@ -0,0 +1,62 @@
+#pragma once
+
+// std
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// external
+#include "json.h"
+
+// Append-only log of the changes made to a graph since it was last saved,
+// one JSON record per line. Each record carries the full state of a top level
+// node or connection after the change (or its removal), so replaying the
+// records in order onto the saved graph restores the edited one, no matter
+// whether the change came from executing, undoing or redoing a command.
+//
+// Records are queued by the UI thread and written in batches by a worker
+// thread, the UI thread never touches the file.
+class UndoJournal {
+public:
+	~UndoJournal();
+
+	bool Open(const std::string& path);
+	// Stops the worker after writing the queued records. The file is deleted
+	// when `discard` is set or nothing is left to recover.
+	void Close(bool discard = false);
+	inline bool IsOpen() const { return _thread.joinable(); }
+	inline const std::string& GetPath() const { return _path; }
+
+	void AppendNode(const std::string& id, nlohmann::json&& data);
+	void AppendNodeRemoved(const std::string& id);
+	void AppendConnection(const std::string& id, nlohmann::json&& data);
+	void AppendConnectionRemoved(const std::string& id);
+
+	// The graph has been saved, everything written or queued so far is obsolete.
+	void Checkpoint();
+
+	// Applies the records of `journalData` to the serialized graph `graphData`.
+	// A truncated last record (e.g. after a crash mid-write) is ignored.
+	static std::string Replay(const std::string& graphData, const std::string& journalData, size_t* recordCount = nullptr);
+
+	inline static constexpr auto BatchInterval = std::chrono::milliseconds(100);
+
+private:
+	std::string _path;
+	std::FILE* _file = nullptr;
+
+	std::thread _thread;
+	std::mutex _mutex;
+	std::condition_variable _condition;
+
+	std::vector<nlohmann::json> _pending;
+	bool _truncate = false;
+	bool _stop = false;
+
+	void Append(nlohmann::json&& record);
+	void Run();
+};
\ No newline at end of file